@@ -0,0 +1,312 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../src/utils.h"
+#include "../src/executor.h"
+#include "../src/numfield.h"
+#include "../src/pipeline.h"
+#include "../src/snapshot.h"
+
+#define MICRO_ITERATIONS 1000000
+#define WRITE_ITERATIONS 20000
+#define MAX_BENCH_WORKERS 8
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Results are "<name> <value> <unit>", one per line, so runs can be diffed */
+static void report(const char *name, double value, const char *unit)
+{
+    printf("%s %.2f %s\n", name, value, unit);
+    fflush(stdout);
+}
+
+static void bench_checksum(void)
+{
+    tar_header header;
+    tar_init_header(&header);
+    unsigned int sink = 0;
+    double start = now();
+    for (int i = 0; i < MICRO_ITERATIONS; i++)
+    {
+        header.name[0] = (char)i;
+        sink += tar_compute_checksum(&header);
+    }
+    report("micro.checksum", (now() - start) * 1e9 / MICRO_ITERATIONS, "ns/op");
+    if (sink == 42)
+        printf("\n");
+}
+
+/**
+ * @brief Build a header with a new size the way fuzz_* functions do: from
+ * tar_init_header() plus a full checksum, and from a template case.
+ */
+static void bench_header_generation(void)
+{
+    tar_header header;
+    unsigned int sink = 0;
+    double start = now();
+    for (int i = 0; i < MICRO_ITERATIONS; i++)
+    {
+        tar_init_header(&header);
+        num_encode(header.size, sizeof(header.size), i, NUM_OCTAL_NUL);
+        sink += tar_compute_checksum(&header);
+    }
+    report("micro.header_init_checksum", (now() - start) * 1e9 / MICRO_ITERATIONS, "ns/op");
+
+    struct tar_case tc;
+    char size[12];
+    start = now();
+    for (int i = 0; i < MICRO_ITERATIONS; i++)
+    {
+        tar_case_init(&tc, TEMPLATE_REGULAR);
+        num_encode(size, sizeof(size), i, NUM_OCTAL_NUL);
+        TAR_CASE_PATCH(&tc, size, size, sizeof(size));
+        tar_case_finalize(&tc);
+        sink += (unsigned char)tc.header.chksum[5];
+    }
+    report("micro.header_template_case", (now() - start) * 1e9 / MICRO_ITERATIONS, "ns/op");
+    if (sink == 42)
+        printf("\n");
+}
+
+static void bench_archive_writing(void)
+{
+    tar_header header;
+    tar_init_header(&header);
+    double start = now();
+    for (int i = 0; i < WRITE_ITERATIONS; i++)
+        tar_generate_empty(&header);
+    report("micro.archive_write_file", (now() - start) * 1e9 / WRITE_ITERATIONS, "ns/op");
+
+    archive_fd = memfd_create("archive.tar", 0);
+    if (archive_fd == -1)
+        return;
+    start = now();
+    for (int i = 0; i < WRITE_ITERATIONS; i++)
+        tar_generate_empty(&header);
+    report("micro.archive_write_memfd", (now() - start) * 1e9 / WRITE_ITERATIONS, "ns/op");
+    close(archive_fd);
+    archive_fd = -1;
+}
+
+/**
+ * @brief Run one backend for @p seconds and return the number of executions,
+ * or -1 if it cannot run the target at all.
+ */
+static long run_backend(const char *backend, char *path, double seconds)
+{
+    char *argv[] = {path, "archive.tar", NULL};
+    struct exec_result res;
+    long execs = 0;
+    double deadline = now() + seconds;
+    while (now() < deadline)
+    {
+        if (strcmp(backend, "popen") == 0 || strcmp(backend, "snapshot") == 0)
+        {
+            if (run_extractor(path) == -1)
+                return -1;
+        }
+        else
+            exec_run(argv, NULL, &res);
+        execs++;
+    }
+    return execs;
+}
+
+/**
+ * @brief Aggregate execs/sec of @p workers processes each running the backend
+ * in its own directory on its own copy of a valid archive.
+ */
+static void bench_executor(const char *target, const char *backend, char *path, int workers, double seconds)
+{
+    int pipes[MAX_BENCH_WORKERS][2];
+    pid_t pids[MAX_BENCH_WORKERS];
+    for (int w = 0; w < workers; w++)
+    {
+        if (pipe(pipes[w]) == -1)
+            return;
+        pids[w] = fork();
+        if (pids[w] == 0)
+        {
+            close(pipes[w][0]);
+            char dir[32];
+            snprintf(dir, sizeof(dir), "worker_%d", w);
+            mkdir(dir, 0755);
+            if (chdir(dir) == -1)
+                _exit(1);
+            freopen("/dev/null", "w", stdout); // run_extractor() chatter
+            long execs = -1;
+            // A target that never opens its archive has no point to snapshot
+            if (strcmp(backend, "snapshot") != 0 || snapshot_init(path) == 0)
+            {
+                tar_header header;
+                tar_init_header(&header);
+                tar_generate_empty(&header);
+                execs = run_backend(backend, path, seconds);
+                snapshot_cleanup();
+            }
+            exec_clear_directory(".");
+            if (write(pipes[w][1], &execs, sizeof(execs)) != sizeof(execs))
+                _exit(1);
+            _exit(0);
+        }
+        close(pipes[w][1]);
+    }
+    long total = 0;
+    int unavailable = 0;
+    for (int w = 0; w < workers; w++)
+    {
+        long execs = 0;
+        if (read(pipes[w][0], &execs, sizeof(execs)) == sizeof(execs))
+        {
+            if (execs < 0)
+                unavailable = 1;
+            else
+                total += execs;
+        }
+        close(pipes[w][0]);
+        waitpid(pids[w], NULL, 0);
+        char dir[32];
+        snprintf(dir, sizeof(dir), "worker_%d", w);
+        rmdir(dir);
+    }
+    if (unavailable)
+    {
+        printf("# %s: %s backend unavailable, skipped\n", target, backend);
+        fflush(stdout);
+        return;
+    }
+    char name[128];
+    snprintf(name, sizeof(name), "macro.%s.%s.workers_%d", target, backend, workers);
+    report(name, total / seconds, "execs/s");
+}
+
+/**
+ * @brief Aggregate execs/sec of the threaded pipeline with @p workers
+ * executors, on mutated archives rather than the fixed valid one.
+ */
+static void bench_pipeline(const char *target, char *path, int workers, double seconds)
+{
+    struct pipeline_config config;
+    struct pipeline_stats stats;
+    memset(&config, 0, sizeof(config));
+    config.extractor = path;
+    config.seconds = seconds;
+    config.executors = workers;
+    config.generators = (workers + 7) / 8;
+    config.quiet = 1;
+    if (pipeline_run(&config, &stats) == -1)
+        return;
+    char name[128];
+    snprintf(name, sizeof(name), "macro.%s.pipeline.workers_%d", target, workers);
+    report(name, stats.archives / stats.elapsed, "execs/s");
+    snprintf(name, sizeof(name), "macro.%s.pipeline.workers_%d.executor_busy", target, workers);
+    report(name, 100 * stats.executor_busy, "%");
+}
+
+/**
+ * @brief Throughput of the pipeline when its controller picks the number of
+ * pinned executors, and the number it settled on.
+ */
+static void bench_adaptive(const char *target, char *path, double seconds)
+{
+    struct pipeline_config config;
+    struct pipeline_stats stats;
+    memset(&config, 0, sizeof(config));
+    config.extractor = path;
+    config.seconds = seconds;
+    config.executors = MAX_BENCH_WORKERS;
+    config.generators = 1;
+    config.adaptive = 1;
+    config.pin = 1;
+    config.quiet = 1;
+    if (pipeline_run(&config, &stats) == -1)
+        return;
+    char name[128];
+    snprintf(name, sizeof(name), "macro.%s.pipeline.adaptive", target);
+    report(name, stats.archives / stats.elapsed, "execs/s");
+    snprintf(name, sizeof(name), "macro.%s.pipeline.adaptive.workers", target);
+    report(name, stats.executors_settled, "workers");
+}
+
+static void bench_target(const char *target, const char *path, double seconds)
+{
+    static const char *backends[] = {"popen", "spawn", "snapshot"};
+    char *resolved = realpath(path, NULL);
+    if (!resolved || access(resolved, X_OK) == -1)
+    {
+        printf("# %s: %s is not executable, skipped\n", target, path);
+        free(resolved);
+        return;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (size_t b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+    {
+        for (int workers = 1; workers <= MAX_BENCH_WORKERS; workers *= 2)
+        {
+            bench_executor(target, backends[b], resolved, workers, seconds);
+            if (workers >= 2 * cpus)
+                break;
+        }
+    }
+    for (int workers = 1; workers <= MAX_BENCH_WORKERS; workers *= 2)
+    {
+        bench_pipeline(target, resolved, workers, seconds);
+        if (workers >= 2 * cpus)
+            break;
+    }
+    bench_adaptive(target, resolved, seconds);
+    free(resolved);
+}
+
+/**
+ * @brief Fuzzer throughput benchmarks, see "make bench".
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        printf("Usage: %s <extractor_path> <stub_extractor_path> [seconds]\n", argv[0]);
+        return 1;
+    }
+    double seconds = argc > 3 ? atof(argv[3]) : 2.0;
+    if (seconds <= 0)
+        seconds = 2.0;
+
+    char workdir[] = "bench_work_XXXXXX";
+    if (!mkdtemp(workdir))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+    char *extractor = realpath(argv[1], NULL);
+    char *stub = realpath(argv[2], NULL);
+    if (chdir(workdir) == -1)
+        return 1;
+    init_test_status(&test_status);
+    tar_templates_init();
+
+    bench_checksum();
+    bench_header_generation();
+    bench_archive_writing();
+    bench_target("extractor", extractor ? extractor : argv[1], seconds);
+    bench_target("stub", stub ? stub : argv[2], seconds);
+
+    exec_clear_directory(".");
+    if (chdir("..") == 0)
+        rmdir(workdir);
+    free(extractor);
+    free(stub);
+    return 0;
+}
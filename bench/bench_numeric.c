@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/numfield.h"
+
+#define ITERATIONS 10000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Compare num_encode() against the snprintf() calls it replaces.
+ */
+int main(void)
+{
+    char field[12];
+    unsigned long long value = 88172645463325252ULL;
+    unsigned long long checksum = 0;
+
+    double start = now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        value ^= value << 13, value ^= value >> 7, value ^= value << 17;
+        snprintf(field, sizeof(field), "%011llo", value & 077777777777ULL);
+        checksum += field[5];
+    }
+    double printf_ns = (now() - start) * 1e9 / ITERATIONS;
+
+    start = now();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        value ^= value << 13, value ^= value >> 7, value ^= value << 17;
+        num_encode(field, sizeof(field), value & 077777777777ULL, NUM_OCTAL_NUL);
+        checksum += field[5];
+    }
+    double encode_ns = (now() - start) * 1e9 / ITERATIONS;
+
+    double format_ns[NUM_FORMAT_COUNT];
+    for (int fmt = 0; fmt < NUM_FORMAT_COUNT; fmt++)
+    {
+        start = now();
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            value ^= value << 13, value ^= value >> 7, value ^= value << 17;
+            num_encode(field, sizeof(field), value, fmt);
+            checksum += field[5];
+        }
+        format_ns[fmt] = (now() - start) * 1e9 / ITERATIONS;
+    }
+
+    printf("micro.numeric.snprintf_octal %.2f ns/op\n", printf_ns);
+    printf("micro.numeric.encode_octal %.2f ns/op\n", encode_ns);
+    for (int fmt = 0; fmt < NUM_FORMAT_COUNT; fmt++)
+        printf("micro.numeric.encode_%s %.2f ns/op\n", num_format_name(fmt), format_ns[fmt]);
+    return checksum == 42; // keep the loops from being optimised away
+}
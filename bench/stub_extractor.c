@@ -0,0 +1,5 @@
+/* Fixed benchmark target: does nothing, so only the executor cost is measured */
+int main(void)
+{
+    return 0;
+}
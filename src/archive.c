@@ -0,0 +1,130 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numfield.h"
+#include "archive.h"
+
+/**
+ * @brief Start an empty archive in a heap buffer that grows as needed.
+ */
+int tar_archive_init(struct tar_archive *a, size_t capacity)
+{
+    a->data = malloc(capacity ? capacity : BLOCK_SIZE);
+    a->length = 0;
+    a->capacity = a->data ? (capacity ? capacity : BLOCK_SIZE) : 0;
+    a->owned = 1;
+    return a->data ? 0 : -1;
+}
+
+/**
+ * @brief Assemble into a caller-owned buffer that already holds @p length bytes.
+ * Appends fail once @p capacity is reached.
+ */
+void tar_archive_wrap(struct tar_archive *a, void *buffer, size_t length, size_t capacity)
+{
+    a->data = buffer;
+    a->length = length;
+    a->capacity = capacity;
+    a->owned = 0;
+}
+
+void tar_archive_reset(struct tar_archive *a)
+{
+    a->length = 0;
+}
+
+void tar_archive_free(struct tar_archive *a)
+{
+    if (a->owned)
+        free(a->data);
+    a->data = NULL;
+    a->length = a->capacity = 0;
+}
+
+static int reserve(struct tar_archive *a, size_t len)
+{
+    if (len > SIZE_MAX - a->length)
+        return -1;
+    size_t needed = a->length + len;
+    if (needed <= a->capacity)
+        return 0;
+    if (!a->owned)
+        return -1;
+    size_t capacity = a->capacity ? a->capacity : BLOCK_SIZE;
+    while (capacity < needed)
+        capacity = capacity <= SIZE_MAX / 2 ? capacity * 2 : needed;
+    char *data = realloc(a->data, capacity);
+    if (!data)
+        return -1;
+    a->data = data;
+    a->capacity = capacity;
+    return 0;
+}
+
+int tar_archive_append(struct tar_archive *a, const void *data, size_t len)
+{
+    if (reserve(a, len) == -1)
+        return -1;
+    memcpy(a->data + a->length, data, len);
+    a->length += len;
+    return 0;
+}
+
+int tar_archive_fill(struct tar_archive *a, char value, size_t len)
+{
+    if (reserve(a, len) == -1)
+        return -1;
+    memset(a->data + a->length, value, len);
+    a->length += len;
+    return 0;
+}
+
+/**
+ * @brief Append a header and its content, zero-padded to the next block.
+ *
+ * The header is written as is: the checksum is the caller's business.
+ */
+int tar_archive_add_entry(struct tar_archive *a, const tar_header *header, const void *content, size_t content_size)
+{
+    size_t padding = (BLOCK_SIZE - content_size % BLOCK_SIZE) % BLOCK_SIZE;
+    if (reserve(a, HEADER_LENGTH + content_size + padding) == -1)
+        return -1;
+    tar_archive_append(a, header, HEADER_LENGTH);
+    if (content_size > 0)
+        tar_archive_append(a, content, content_size);
+    return tar_archive_fill(a, '\0', padding);
+}
+
+/**
+ * @brief Append an end-of-archive marker of @p end_size zero bytes (END_BYTES normally).
+ */
+int tar_archive_add_end(struct tar_archive *a, size_t end_size)
+{
+    return tar_archive_fill(a, '\0', end_size);
+}
+
+/**
+ * @brief Find the header blocks of an archive by following the size fields.
+ *
+ * Stops at the first all-zero block or when a size runs past the end.
+ *
+ * @return Number of offsets stored in @p offsets (at most @p max_offsets).
+ */
+size_t tar_archive_headers(const char *data, size_t length, size_t *offsets, size_t max_offsets)
+{
+    static const char zero_block[BLOCK_SIZE];
+    size_t count = 0;
+    size_t offset = 0;
+    while (offset + HEADER_LENGTH <= length && count < max_offsets)
+    {
+        if (memcmp(data + offset, zero_block, BLOCK_SIZE) == 0)
+            break;
+        offsets[count++] = offset;
+        const tar_header *header = (const tar_header *)(data + offset);
+        unsigned long long size = num_decode(header->size, sizeof(header->size));
+        if (size > length - offset - HEADER_LENGTH)
+            break;
+        offset += HEADER_LENGTH + (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+    return count;
+}
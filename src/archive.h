@@ -0,0 +1,26 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+#include <stddef.h>
+#include "constants.h"
+
+/* An archive assembled in memory, either in a growable heap buffer or in a
+ * fixed buffer owned by the caller (e.g. libFuzzer's Data/MaxSize). */
+struct tar_archive
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    int owned; /* data was allocated here and may grow */
+};
+
+int tar_archive_init(struct tar_archive *a, size_t capacity);
+void tar_archive_wrap(struct tar_archive *a, void *buffer, size_t length, size_t capacity);
+void tar_archive_reset(struct tar_archive *a);
+void tar_archive_free(struct tar_archive *a);
+int tar_archive_append(struct tar_archive *a, const void *data, size_t len);
+int tar_archive_fill(struct tar_archive *a, char value, size_t len);
+int tar_archive_add_entry(struct tar_archive *a, const tar_header *header, const void *content, size_t content_size);
+int tar_archive_add_end(struct tar_archive *a, size_t end_size);
+size_t tar_archive_headers(const char *data, size_t length, size_t *offsets, size_t max_offsets);
+
+#endif
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "template.h"
+#include "numfield.h"
+#include "corpus.h"
+
+void corpus_init(struct corpus *c)
+{
+    memset(c, 0, sizeof(struct corpus));
+}
+
+/**
+ * @brief Check a header block: known magic (POSIX, GNU or none for v7) and a
+ * stored checksum matching either the unsigned or the historical signed sum.
+ */
+static int valid_header(const tar_header *header)
+{
+    if (memcmp(header->magic, TMAGIC, 5) != 0 && header->magic[0] != '\0')
+        return 0;
+    unsigned long long stored = num_decode(header->chksum, sizeof(header->chksum));
+    if (stored == tar_header_sum(header))
+        return 1;
+    const signed char *raw = (const signed char *)header;
+    int signed_sum = ' ' * CHKSUM_LENGTH;
+    for (int i = 0; i < HEADER_LENGTH; i++)
+    {
+        if (i < CHKSUM_OFFSET || i >= CHKSUM_OFFSET + CHKSUM_LENGTH)
+            signed_sum += raw[i];
+    }
+    return stored == (unsigned long long)(long long)signed_sum;
+}
+
+static int add_entry(struct corpus *c, const tar_header *header, const char *payload, unsigned long long size)
+{
+    if (c->entry_count == c->entry_capacity)
+    {
+        size_t capacity = c->entry_capacity ? c->entry_capacity * 2 : 256;
+        struct corpus_entry *entries = realloc(c->entries, capacity * sizeof(struct corpus_entry));
+        if (!entries)
+            return -1;
+        c->entries = entries;
+        c->entry_capacity = capacity;
+    }
+    struct corpus_entry *e = &c->entries[c->entry_count++];
+    e->header = header;
+    e->payload = payload;
+    e->payload_size = size;
+    e->archive = c->archive_count - 1;
+    return 0;
+}
+
+/**
+ * @brief Map a tar file and register each of its entries as a seed.
+ *
+ * Only header blocks are read: payloads are skipped by their size field and
+ * the mapping is advised random so the kernel does not read ahead into them.
+ * Walking stops at the end marker or at the first invalid header.
+ *
+ * @return Number of entries registered, or -1 if the file cannot be mapped.
+ */
+int corpus_add_file(struct corpus *c, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size < HEADER_LENGTH)
+    {
+        close(fd);
+        return -1;
+    }
+    size_t length = st.st_size;
+    const char *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    posix_madvise((void *)map, length, POSIX_MADV_RANDOM);
+
+    if (c->archive_count == c->archive_capacity)
+    {
+        size_t capacity = c->archive_capacity ? c->archive_capacity * 2 : 16;
+        struct corpus_archive *archives = realloc(c->archives, capacity * sizeof(struct corpus_archive));
+        if (!archives)
+        {
+            munmap((void *)map, length);
+            return -1;
+        }
+        c->archives = archives;
+        c->archive_capacity = capacity;
+    }
+    struct corpus_archive *a = &c->archives[c->archive_count++];
+    snprintf(a->path, sizeof(a->path), "%s", path);
+    a->map = map;
+    a->length = length;
+
+    static const char zero_block[BLOCK_SIZE];
+    int added = 0;
+    size_t offset = 0;
+    while (offset + HEADER_LENGTH <= length)
+    {
+        const tar_header *header = (const tar_header *)(map + offset);
+        if (memcmp(header, zero_block, BLOCK_SIZE) == 0)
+            break;
+        unsigned long long size = num_decode(header->size, sizeof(header->size));
+        if (!valid_header(header) || size > length - offset - HEADER_LENGTH)
+        {
+            c->invalid_headers++;
+            break;
+        }
+        if (add_entry(c, header, map + offset + HEADER_LENGTH, size) == -1)
+            break;
+        added++;
+        offset += HEADER_LENGTH + (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+    return added;
+}
+
+/**
+ * @brief Register every *.tar file of a directory.
+ * @return Number of archives mapped, or -1 if the directory cannot be read.
+ */
+int corpus_load_dir(struct corpus *c, const char *dir)
+{
+    DIR *d = opendir(dir);
+    if (!d)
+        return -1;
+    struct dirent *de;
+    char path[512];
+    int loaded = 0;
+    while ((de = readdir(d)) != NULL)
+    {
+        size_t len = strlen(de->d_name);
+        if (len < 4 || strcmp(de->d_name + len - 4, ".tar") != 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+        if (corpus_add_file(c, path) >= 0)
+            loaded++;
+    }
+    closedir(d);
+    return loaded;
+}
+
+void corpus_free(struct corpus *c)
+{
+    for (size_t i = 0; i < c->archive_count; i++)
+        munmap((void *)c->archives[i].map, c->archives[i].length);
+    free(c->archives);
+    free(c->entries);
+    corpus_init(c);
+}
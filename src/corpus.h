@@ -0,0 +1,39 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+#include <stddef.h>
+#include "constants.h"
+
+/* One entry of a mapped archive. header and payload point into the mapping,
+ * nothing is copied. */
+struct corpus_entry
+{
+    const tar_header *header;
+    const char *payload;
+    unsigned long long payload_size;
+    size_t archive; /* index into corpus.archives */
+};
+
+struct corpus_archive
+{
+    char path[256];
+    const char *map;
+    size_t length;
+};
+
+struct corpus
+{
+    struct corpus_archive *archives;
+    size_t archive_count;
+    size_t archive_capacity;
+    struct corpus_entry *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+    unsigned long invalid_headers; /* archives cut short by a bad header */
+};
+
+void corpus_init(struct corpus *c);
+int corpus_add_file(struct corpus *c, const char *path);
+int corpus_load_dir(struct corpus *c, const char *dir);
+void corpus_free(struct corpus *c);
+
+#endif
@@ -0,0 +1,278 @@
+#include <stdlib.h>
+#include <string.h>
+#include "covering.h"
+
+#define CANDIDATE_ROWS 16 /* rows built per step, the one covering the most new tuples is kept */
+#define UNSET 0xFF
+
+/* One set of `strength` factors; its tuples are numbered from base */
+struct combo
+{
+    unsigned char factor[COVERING_MAX_STRENGTH];
+    size_t base;
+};
+
+struct builder
+{
+    const unsigned char *levels;
+    size_t factors;
+    int strength;
+    struct combo *combos;
+    size_t combo_count;
+    size_t *by_factor; /* for every factor, the combos containing it */
+    size_t per_factor; /* combos containing a given factor */
+    unsigned char *uncovered;
+    size_t uncovered_count;
+};
+
+static size_t binomial(size_t n, int k)
+{
+    size_t r = 1;
+    for (int i = 1; i <= k; i++)
+        r = r * (n - k + i) / i;
+    return r;
+}
+
+static size_t tuple_index(const struct builder *b, const struct combo *c, const unsigned char *row)
+{
+    size_t index = 0;
+    for (int i = 0; i < b->strength; i++)
+        index = index * b->levels[c->factor[i]] + row[c->factor[i]];
+    return c->base + index;
+}
+
+static int combo_fixed(const struct builder *b, const struct combo *c, const unsigned char *row)
+{
+    for (int i = 0; i < b->strength; i++)
+    {
+        if (row[c->factor[i]] == UNSET)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Enumerate every set of `strength` factors in lexicographic order and
+ * index them by factor.
+ */
+static int builder_init(struct builder *b, const unsigned char *levels, size_t factors, int strength)
+{
+    memset(b, 0, sizeof(struct builder));
+    b->levels = levels;
+    b->factors = factors;
+    b->strength = strength;
+    b->combo_count = binomial(factors, strength);
+    b->per_factor = binomial(factors - 1, strength - 1);
+    b->combos = malloc(b->combo_count * sizeof(struct combo));
+    b->by_factor = malloc(factors * b->per_factor * sizeof(size_t));
+    if (!b->combos || !b->by_factor)
+        return -1;
+
+    size_t filled[COVERING_MAX_FACTORS] = {0};
+    size_t pick[COVERING_MAX_STRENGTH];
+    size_t tuples = 0;
+    for (int i = 0; i < strength; i++)
+        pick[i] = i;
+    for (size_t n = 0; n < b->combo_count; n++)
+    {
+        struct combo *c = &b->combos[n];
+        size_t span = 1;
+        for (int i = 0; i < strength; i++)
+        {
+            c->factor[i] = (unsigned char)pick[i];
+            span *= levels[pick[i]];
+            b->by_factor[pick[i] * b->per_factor + filled[pick[i]]++] = n;
+        }
+        c->base = tuples;
+        tuples += span;
+
+        int i = strength - 1;
+        while (i >= 0 && pick[i] == factors - strength + i)
+            i--;
+        if (i < 0)
+            break;
+        pick[i]++;
+        for (int j = i + 1; j < strength; j++)
+            pick[j] = pick[j - 1] + 1;
+    }
+
+    b->uncovered = malloc(tuples);
+    if (!b->uncovered)
+        return -1;
+    memset(b->uncovered, 1, tuples);
+    b->uncovered_count = tuples;
+    return 0;
+}
+
+static void builder_free(struct builder *b)
+{
+    free(b->combos);
+    free(b->by_factor);
+    free(b->uncovered);
+}
+
+/**
+ * @brief Fix the levels of one uncovered tuple in @p row, picked at random.
+ */
+static void seed_row(struct builder *b, struct tar_mutator *m, unsigned char *row, size_t tuples)
+{
+    size_t t = tar_mutator_below(m, tuples);
+    while (!b->uncovered[t])
+        t = (t + 1) % tuples;
+
+    size_t lo = 0, hi = b->combo_count;
+    while (hi - lo > 1)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (b->combos[mid].base <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    const struct combo *c = &b->combos[lo];
+    size_t index = t - c->base;
+    for (int i = b->strength - 1; i >= 0; i--)
+    {
+        row[c->factor[i]] = (unsigned char)(index % b->levels[c->factor[i]]);
+        index /= b->levels[c->factor[i]];
+    }
+}
+
+/**
+ * @brief Greedily complete a seeded row, AETG style.
+ *
+ * Free factors are visited in random order; each takes the level that
+ * completes the most uncovered tuples with the factors already fixed.
+ */
+static void complete_row(struct builder *b, struct tar_mutator *m, unsigned char *row)
+{
+    size_t order[COVERING_MAX_FACTORS];
+    for (size_t f = 0; f < b->factors; f++)
+        order[f] = f;
+    for (size_t i = b->factors - 1; i > 0; i--)
+    {
+        size_t j = tar_mutator_below(m, i + 1);
+        size_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (size_t i = 0; i < b->factors; i++)
+    {
+        size_t f = order[i];
+        if (row[f] != UNSET)
+            continue;
+        const size_t *combos = &b->by_factor[f * b->per_factor];
+        size_t best_gain = 0, ties = 0;
+        unsigned char best = 0;
+        for (unsigned char v = 0; v < b->levels[f]; v++)
+        {
+            row[f] = v;
+            size_t gain = 0;
+            for (size_t k = 0; k < b->per_factor; k++)
+            {
+                const struct combo *c = &b->combos[combos[k]];
+                if (combo_fixed(b, c, row))
+                    gain += b->uncovered[tuple_index(b, c, row)];
+            }
+            if (v == 0 || gain > best_gain)
+            {
+                best_gain = gain;
+                best = v;
+                ties = 1;
+            }
+            else if (gain == best_gain && tar_mutator_below(m, ++ties) == 0)
+                best = v;
+        }
+        row[f] = best;
+    }
+}
+
+static size_t row_gain(const struct builder *b, const unsigned char *row)
+{
+    size_t gain = 0;
+    for (size_t n = 0; n < b->combo_count; n++)
+        gain += b->uncovered[tuple_index(b, &b->combos[n], row)];
+    return gain;
+}
+
+/**
+ * @brief Build a covering array of strength @p strength over @p factors
+ * factors, factor f taking levels[f] distinct levels.
+ *
+ * Rows are added greedily until every t-tuple is covered, so the array is
+ * small but not optimal: about 175 rows for 16 factors of 3-4 levels at
+ * t=3. Randomness comes from @p m.
+ *
+ * @return 0, or -1 on invalid parameters or allocation failure.
+ */
+int covering_array_build(struct covering_array *ca, const unsigned char *levels, size_t factors, int strength,
+                         struct tar_mutator *m)
+{
+    memset(ca, 0, sizeof(struct covering_array));
+    if (strength < 1 || strength > COVERING_MAX_STRENGTH || factors < (size_t)strength ||
+        factors > COVERING_MAX_FACTORS)
+        return -1;
+    for (size_t f = 0; f < factors; f++)
+    {
+        if (levels[f] == 0 || levels[f] > COVERING_MAX_LEVELS)
+            return -1;
+    }
+
+    struct builder b;
+    if (builder_init(&b, levels, factors, strength) == -1)
+    {
+        builder_free(&b);
+        return -1;
+    }
+    ca->factors = factors;
+    ca->strength = strength;
+    ca->tuples = b.uncovered_count;
+
+    unsigned char candidate[COVERING_MAX_FACTORS], best[COVERING_MAX_FACTORS];
+    while (b.uncovered_count > 0)
+    {
+        size_t best_gain = 0;
+        for (int n = 0; n < CANDIDATE_ROWS; n++)
+        {
+            memset(candidate, UNSET, factors);
+            seed_row(&b, m, candidate, ca->tuples);
+            complete_row(&b, m, candidate);
+            size_t gain = row_gain(&b, candidate);
+            if (gain > best_gain)
+            {
+                best_gain = gain;
+                memcpy(best, candidate, factors);
+            }
+        }
+
+        if (ca->rows == ca->capacity)
+        {
+            size_t capacity = ca->capacity ? ca->capacity * 2 : 64;
+            unsigned char *cells = realloc(ca->cells, capacity * factors);
+            if (!cells)
+            {
+                builder_free(&b);
+                covering_array_free(ca);
+                return -1;
+            }
+            ca->cells = cells;
+            ca->capacity = capacity;
+        }
+        memcpy(ca->cells + ca->rows++ * factors, best, factors);
+        for (size_t n = 0; n < b.combo_count; n++)
+        {
+            size_t t = tuple_index(&b, &b.combos[n], best);
+            b.uncovered_count -= b.uncovered[t];
+            b.uncovered[t] = 0;
+        }
+    }
+    builder_free(&b);
+    return 0;
+}
+
+void covering_array_free(struct covering_array *ca)
+{
+    free(ca->cells);
+    memset(ca, 0, sizeof(struct covering_array));
+}
@@ -0,0 +1,31 @@
+#ifndef COVERING_H
+#define COVERING_H
+#include <stddef.h>
+#include "mutate.h"
+
+#define COVERING_MAX_FACTORS 32
+#define COVERING_MAX_LEVELS 16
+#define COVERING_MAX_STRENGTH 3
+
+/* A covering array: rows of one level per factor such that every
+ * combination of levels of every `strength` factors appears in some row. */
+struct covering_array
+{
+    size_t factors;
+    int strength;
+    size_t tuples; /* t-tuples covered, i.e. the size of the search space */
+    size_t rows;
+    size_t capacity;
+    unsigned char *cells; /* rows * factors levels, row major */
+};
+
+int covering_array_build(struct covering_array *ca, const unsigned char *levels, size_t factors, int strength,
+                         struct tar_mutator *m);
+void covering_array_free(struct covering_array *ca);
+
+static inline const unsigned char *covering_array_row(const struct covering_array *ca, size_t row)
+{
+    return ca->cells + row * ca->factors;
+}
+
+#endif
@@ -0,0 +1,141 @@
+#include <string.h>
+#include "numfield.h"
+#include "crossover.h"
+
+#define MAX_CROSSOVER_ENTRIES 64
+
+/* Every field of tar_header, in order; crossover never cuts inside one */
+static const struct
+{
+    size_t offset;
+    size_t width;
+} header_fields[] = {
+    {offsetof(tar_header, name), sizeof(((tar_header *)0)->name)},
+    {offsetof(tar_header, mode), sizeof(((tar_header *)0)->mode)},
+    {offsetof(tar_header, uid), sizeof(((tar_header *)0)->uid)},
+    {offsetof(tar_header, gid), sizeof(((tar_header *)0)->gid)},
+    {offsetof(tar_header, size), sizeof(((tar_header *)0)->size)},
+    {offsetof(tar_header, mtime), sizeof(((tar_header *)0)->mtime)},
+    {offsetof(tar_header, chksum), sizeof(((tar_header *)0)->chksum)},
+    {offsetof(tar_header, typeflag), sizeof(((tar_header *)0)->typeflag)},
+    {offsetof(tar_header, linkname), sizeof(((tar_header *)0)->linkname)},
+    {offsetof(tar_header, magic), sizeof(((tar_header *)0)->magic)},
+    {offsetof(tar_header, version), sizeof(((tar_header *)0)->version)},
+    {offsetof(tar_header, uname), sizeof(((tar_header *)0)->uname)},
+    {offsetof(tar_header, gname), sizeof(((tar_header *)0)->gname)},
+    {offsetof(tar_header, devmajor), sizeof(((tar_header *)0)->devmajor)},
+    {offsetof(tar_header, devminor), sizeof(((tar_header *)0)->devminor)},
+    {offsetof(tar_header, prefix), sizeof(((tar_header *)0)->prefix)},
+    {offsetof(tar_header, padding), sizeof(((tar_header *)0)->padding)},
+};
+
+#define HEADER_FIELD_COUNT (sizeof(header_fields) / sizeof(header_fields[0]))
+#define SIZE_FIELD 4
+#define CHKSUM_FIELD 6
+
+/**
+ * @brief Combine two headers field by field and fix the checksum.
+ *
+ * Either every field is drawn independently from @p a or @p b, or the
+ * fields before a random cut come from @p a and the rest from @p b. The
+ * chksum field is never taken from @p b: it is recomputed over the child.
+ *
+ * @param size_from_b Set to 1 if the size field came from @p b, so the
+ *                    caller can pair the header with the matching payload.
+ */
+void tar_crossover_header(struct tar_mutator *m, struct tar_case *out, const tar_header *a, const tar_header *b,
+                          int *size_from_b)
+{
+    tar_case_load(out, a);
+    const char *other = (const char *)b;
+    int uniform = tar_mutator_below(m, 2);
+    size_t cut = 1 + tar_mutator_below(m, HEADER_FIELD_COUNT - 1);
+    unsigned long long bits = tar_mutator_next(m);
+    *size_from_b = 0;
+    for (size_t f = 0; f < HEADER_FIELD_COUNT; f++)
+    {
+        int from_b = uniform ? (int)((bits >> f) & 1) : f >= cut;
+        if (!from_b || f == CHKSUM_FIELD)
+            continue;
+        tar_case_patch(out, header_fields[f].offset, other + header_fields[f].offset, header_fields[f].width);
+        if (f == SIZE_FIELD)
+            *size_from_b = 1;
+    }
+    tar_case_finalize(out);
+}
+
+/**
+ * @brief End of the entry at @p offset: header, payload and padding, clipped
+ * to the archive and to @p payload_limit bytes of payload.
+ *
+ * The size is checked against what is left before any arithmetic, as in
+ * tar_archive_headers(): a base-256 size near 2^64 would otherwise wrap the
+ * end below @p offset.
+ */
+static size_t entry_end(const char *data, size_t length, size_t offset, size_t payload_limit)
+{
+    const tar_header *header = (const tar_header *)(data + offset);
+    unsigned long long size = num_decode(header->size, sizeof(header->size));
+    if (size > length - offset - HEADER_LENGTH)
+        size = length - offset - HEADER_LENGTH;
+    if (size > payload_limit)
+        size = payload_limit;
+    unsigned long long end = offset + HEADER_LENGTH + (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    return end < length ? (size_t)end : length;
+}
+
+static int append_entries(struct tar_archive *out, const char *data, size_t length, const size_t *offsets,
+                          size_t from, size_t to, size_t payload_limit)
+{
+    for (size_t i = from; i < to; i++)
+    {
+        size_t end = entry_end(data, length, offsets[i], payload_limit);
+        if (tar_archive_append(out, data + offsets[i], end - offsets[i]) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Build an archive from whole entries of two parents, appended to @p out.
+ *
+ * Three shapes: a prefix of @p a followed by a suffix of @p b, @p a with one
+ * entry replaced by one of @p b, or @p a with one entry of @p b inserted.
+ * Entries are copied straight from the parents into @p out, headers intact;
+ * at most @p payload_limit bytes of each payload are, whatever its size
+ * field says (SIZE_MAX for all of it).
+ *
+ * @return 0, or -1 if a parent has no entry or @p out is full.
+ */
+int tar_crossover_archive(struct tar_mutator *m, struct tar_archive *out, const char *a, size_t a_length,
+                          const char *b, size_t b_length, size_t payload_limit)
+{
+    size_t a_offsets[MAX_CROSSOVER_ENTRIES], b_offsets[MAX_CROSSOVER_ENTRIES];
+    size_t a_count = tar_archive_headers(a, a_length, a_offsets, MAX_CROSSOVER_ENTRIES);
+    size_t b_count = tar_archive_headers(b, b_length, b_offsets, MAX_CROSSOVER_ENTRIES);
+    if (a_count == 0 || b_count == 0)
+        return -1;
+
+    size_t i = tar_mutator_below(m, a_count + 1);
+    size_t j = tar_mutator_below(m, b_count);
+    int rv;
+    switch (tar_mutator_below(m, 3))
+    {
+    case 0:
+        rv = append_entries(out, a, a_length, a_offsets, 0, i, payload_limit) |
+             append_entries(out, b, b_length, b_offsets, j, b_count, payload_limit);
+        break;
+    case 1:
+        i = i == a_count ? a_count - 1 : i;
+        rv = append_entries(out, a, a_length, a_offsets, 0, i, payload_limit) |
+             append_entries(out, b, b_length, b_offsets, j, j + 1, payload_limit) |
+             append_entries(out, a, a_length, a_offsets, i + 1, a_count, payload_limit);
+        break;
+    default:
+        rv = append_entries(out, a, a_length, a_offsets, 0, i, payload_limit) |
+             append_entries(out, b, b_length, b_offsets, j, j + 1, payload_limit) |
+             append_entries(out, a, a_length, a_offsets, i, a_count, payload_limit);
+        break;
+    }
+    return rv | tar_archive_add_end(out, END_BYTES);
+}
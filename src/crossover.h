@@ -0,0 +1,13 @@
+#ifndef CROSSOVER_H
+#define CROSSOVER_H
+#include <stddef.h>
+#include "archive.h"
+#include "template.h"
+#include "mutate.h"
+
+void tar_crossover_header(struct tar_mutator *m, struct tar_case *out, const tar_header *a, const tar_header *b,
+                          int *size_from_b);
+int tar_crossover_archive(struct tar_mutator *m, struct tar_archive *out, const char *a, size_t a_length,
+                          const char *b, size_t b_length, size_t payload_limit);
+
+#endif
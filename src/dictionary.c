@@ -0,0 +1,280 @@
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "dictionary.h"
+
+void tar_dictionary_init(struct tar_dictionary *d)
+{
+    memset(d, 0, sizeof(struct tar_dictionary));
+}
+
+/**
+ * @return 1 if added, 0 if already there, -1 if it does not fit.
+ */
+int tar_dictionary_add_token(struct tar_dictionary *d, const char *bytes, size_t length)
+{
+    if (length == 0 || length > TAR_TOKEN_MAX)
+        return -1;
+    for (size_t i = 0; i < d->token_count; i++)
+    {
+        if (d->tokens[i].length == length && memcmp(d->tokens[i].bytes, bytes, length) == 0)
+            return 0;
+    }
+    if (d->token_count == TAR_DICTIONARY_TOKENS)
+        return -1;
+    d->tokens[d->token_count].length = length;
+    memcpy(d->tokens[d->token_count].bytes, bytes, length);
+    d->token_count++;
+    return 1;
+}
+
+/**
+ * @return 1 if added, 0 if already there, -1 if the dictionary is full.
+ */
+int tar_dictionary_add_value(struct tar_dictionary *d, unsigned long long value)
+{
+    for (size_t i = 0; i < d->value_count; i++)
+    {
+        if (d->values[i] == value)
+            return 0;
+    }
+    if (d->value_count == TAR_DICTIONARY_VALUES)
+        return -1;
+    d->values[d->value_count++] = value;
+    return 1;
+}
+
+static int printable(unsigned char c)
+{
+    return (c >= ' ' && c < 0x7F) || c == '\n' || c == '\t';
+}
+
+/**
+ * @brief Take every NUL-terminated printable string short enough to be a
+ * field value, e.g. "ustar", "00" or "../". printf formats and lines ending
+ * in a newline are what the target writes, not what it reads, so they are
+ * left out.
+ */
+static void scan_strings(struct tar_dictionary *d, const unsigned char *data, size_t size)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t start = i;
+        while (i < size && printable(data[i]))
+            i++;
+        if (i < size && data[i] == '\0' && i > start && data[i - 1] != '\n' &&
+            !memchr(data + start, '%', i - start))
+            tar_dictionary_add_token(d, (const char *)data + start, i - start);
+        i++;
+    }
+}
+
+/**
+ * @brief Length of a ModRM byte with its SIB byte and displacement, in
+ * 64-bit mode, or 0 if it runs past @p end.
+ */
+static size_t modrm_length(const unsigned char *p, const unsigned char *end)
+{
+    if (p >= end)
+        return 0;
+    unsigned char mod = p[0] >> 6, rm = p[0] & 7;
+    size_t length = 1;
+    if (mod != 3 && rm == 4)
+    {
+        if (p + 1 >= end)
+            return 0;
+        if (mod == 0 && (p[1] & 7) == 5)
+            length += 4; // SIB with no base: disp32
+        length++;
+    }
+    if (mod == 1)
+        length += 1;
+    else if (mod == 2 || (mod == 0 && rm == 5))
+        length += 4; // disp32, or RIP-relative
+    return p + length <= end ? length : 0;
+}
+
+static unsigned long long little_endian(const unsigned char *p, size_t width)
+{
+    unsigned long long value = 0;
+    for (size_t i = width; i-- > 0;)
+        value = value << 8 | p[i];
+    return value;
+}
+
+/**
+ * @brief Record the immediate of a cmp: printable bytes as a token, and
+ * word-sized values other than 0, 1 and -1 as integers.
+ */
+static void add_immediate(struct tar_dictionary *d, const unsigned char *imm, size_t width, int is_value)
+{
+    int text = 1;
+    for (size_t i = 0; i < width; i++)
+        text = text && imm[i] >= ' ' && imm[i] < 0x7F;
+    if (text)
+        tar_dictionary_add_token(d, (const char *)imm, width);
+    if (!is_value)
+        return;
+    unsigned long long value = little_endian(imm, width);
+    if (width == 1 && (value & 0x80))
+        return; // sign-extended: negative
+    if (width == 4 && (value & 0x80000000))
+        return;
+    if (value > 1)
+        tar_dictionary_add_value(d, value);
+}
+
+/**
+ * @brief Split a 64-bit immediate made only of printable bytes and NULs,
+ * like the "ustar\0" "00" a compiler loads with one movabs, into strings.
+ */
+static void add_packed_string(struct tar_dictionary *d, const unsigned char *imm)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        if (imm[i] != '\0' && !(imm[i] >= ' ' && imm[i] < 0x7F))
+            return;
+    }
+    for (int i = 0; i < 8;)
+    {
+        int start = i;
+        while (i < 8 && imm[i] != '\0')
+            i++;
+        if (i - start >= 2)
+            tar_dictionary_add_token(d, (const char *)imm + start, i - start);
+        i++;
+    }
+}
+
+/**
+ * @brief Look for the immediate operands of cmp at every byte offset of
+ * x86-64 code: 3C ib, 3D id, 80 /7 ib, 81 /7 id, 83 /7 ib, and of
+ * movabs r64, imm64 (REX.W B8+r io) for strings built in registers.
+ *
+ * Without a full disassembler some matches start inside other instructions;
+ * requiring printable bytes for tokens keeps that noise small.
+ */
+static void scan_code(struct tar_dictionary *d, const unsigned char *code, size_t size)
+{
+    const unsigned char *end = code + size;
+    for (const unsigned char *p = code; p < end; p++)
+    {
+        const unsigned char *op = p;
+        size_t word = 4;
+        if (*op == 0x66)
+        {
+            word = 2;
+            op++;
+        }
+        int rex_w = 0;
+        if (op < end && (*op & 0xF0) == 0x40)
+        {
+            rex_w = (*op & 0x08) != 0;
+            op++;
+        }
+        if (op + 1 >= end)
+            break;
+        size_t modrm;
+        switch (*op)
+        {
+        case 0x3C:
+            add_immediate(d, op + 1, 1, 0);
+            break;
+        case 0x3D:
+            if (op + 1 + word <= end)
+                add_immediate(d, op + 1, word, 1);
+            break;
+        case 0x80:
+        case 0x81:
+        case 0x83:
+            if (((op[1] >> 3) & 7) != 7)
+                break;
+            modrm = modrm_length(op + 1, end);
+            if (modrm == 0)
+                break;
+            if (*op == 0x81 && op + 1 + modrm + word <= end)
+                add_immediate(d, op + 1 + modrm, word, 1);
+            else if (*op != 0x81 && op + 1 + modrm < end)
+                add_immediate(d, op + 1 + modrm, 1, *op == 0x83);
+            break;
+        default:
+            if (rex_w && (*op & 0xF8) == 0xB8 && op + 9 <= end)
+                add_packed_string(d, op + 1);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Build a dictionary from an ELF64 image: the strings of its
+ * .rodata sections and, for x86-64, the immediates its code compares with.
+ *
+ * @return The number of new tokens and values, or -1 if @p image is not a
+ *         little-endian ELF64 file with sane section headers.
+ */
+int tar_dictionary_scan_elf(struct tar_dictionary *d, const unsigned char *image, size_t size)
+{
+    if (size < sizeof(Elf64_Ehdr) || memcmp(image, ELFMAG, SELFMAG) != 0 || image[EI_CLASS] != ELFCLASS64 ||
+        image[EI_DATA] != ELFDATA2LSB)
+        return -1;
+    Elf64_Ehdr ehdr;
+    memcpy(&ehdr, image, sizeof(ehdr));
+    if (ehdr.e_shentsize != sizeof(Elf64_Shdr) || ehdr.e_shoff > size ||
+        ehdr.e_shnum > (size - ehdr.e_shoff) / sizeof(Elf64_Shdr) || ehdr.e_shstrndx >= ehdr.e_shnum)
+        return -1;
+
+    Elf64_Shdr names;
+    memcpy(&names, image + ehdr.e_shoff + ehdr.e_shstrndx * sizeof(Elf64_Shdr), sizeof(names));
+    if (names.sh_offset > size || names.sh_size > size - names.sh_offset)
+        return -1;
+
+    size_t before = d->token_count + d->value_count;
+    for (size_t i = 0; i < ehdr.e_shnum; i++)
+    {
+        Elf64_Shdr shdr;
+        memcpy(&shdr, image + ehdr.e_shoff + i * sizeof(Elf64_Shdr), sizeof(shdr));
+        if (shdr.sh_type == SHT_NOBITS || shdr.sh_offset > size || shdr.sh_size > size - shdr.sh_offset)
+            continue;
+        const unsigned char *data = image + shdr.sh_offset;
+        if (shdr.sh_flags & SHF_EXECINSTR)
+        {
+            if (ehdr.e_machine == EM_X86_64)
+                scan_code(d, data, shdr.sh_size);
+            continue;
+        }
+        const char *name = "";
+        if (shdr.sh_name < names.sh_size &&
+            memchr(image + names.sh_offset + shdr.sh_name, '\0', names.sh_size - shdr.sh_name))
+            name = (const char *)image + names.sh_offset + shdr.sh_name;
+        if ((shdr.sh_flags & SHF_ALLOC) && !(shdr.sh_flags & SHF_WRITE) && strncmp(name, ".rodata", 7) == 0)
+            scan_strings(d, data, shdr.sh_size);
+    }
+    return (int)(d->token_count + d->value_count - before);
+}
+
+/**
+ * @brief tar_dictionary_scan_elf() on a file, mapped rather than read.
+ */
+int tar_dictionary_load_elf(struct tar_dictionary *d, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0)
+    {
+        close(fd);
+        return -1;
+    }
+    void *image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+        return -1;
+    int added = tar_dictionary_scan_elf(d, image, st.st_size);
+    munmap(image, st.st_size);
+    return added;
+}
@@ -0,0 +1,31 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+#include <stddef.h>
+
+#define TAR_TOKEN_MAX 32         /* longer strings are messages, not field values */
+#define TAR_DICTIONARY_TOKENS 256
+#define TAR_DICTIONARY_VALUES 64
+
+struct tar_token
+{
+    unsigned char length;
+    char bytes[TAR_TOKEN_MAX];
+};
+
+/* Literals a target compares its input with: byte strings for the text
+ * fields and integers for the numeric ones. Filled once, read-only after. */
+struct tar_dictionary
+{
+    struct tar_token tokens[TAR_DICTIONARY_TOKENS];
+    size_t token_count;
+    unsigned long long values[TAR_DICTIONARY_VALUES];
+    size_t value_count;
+};
+
+void tar_dictionary_init(struct tar_dictionary *d);
+int tar_dictionary_add_token(struct tar_dictionary *d, const char *bytes, size_t length);
+int tar_dictionary_add_value(struct tar_dictionary *d, unsigned long long value);
+int tar_dictionary_scan_elf(struct tar_dictionary *d, const unsigned char *image, size_t size);
+int tar_dictionary_load_elf(struct tar_dictionary *d, const char *path);
+
+#endif
@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "executor.h"
+#include "differential.h"
+
+#define MAX_TARGET_ARGS 16
+#define ENTRY_PATH_LENGTH 256
+
+struct diff_entry
+{
+    char path[ENTRY_PATH_LENGTH];
+    long long size;
+    unsigned int mode;
+};
+
+struct diff_target
+{
+    char command[256];
+    char executable[256];
+    char *argv[MAX_TARGET_ARGS + 2]; /* command words + archive path + NULL */
+    char sandbox[32];
+    struct exec_result result;
+    struct diff_entry *entries;
+    size_t entry_count;
+    size_t entry_capacity;
+};
+
+static const char *reference_commands[MAX_DIFF_TARGETS - 1];
+static int reference_count;
+static struct diff_target targets[MAX_DIFF_TARGETS];
+static int target_count;
+static int enabled;
+static char archive_path[32];
+
+static void add_entry(struct diff_target *t, const char *path, struct stat *st)
+{
+    if (t->entry_count == t->entry_capacity)
+    {
+        size_t capacity = t->entry_capacity ? t->entry_capacity * 2 : 16;
+        struct diff_entry *entries = realloc(t->entries, capacity * sizeof(struct diff_entry));
+        if (!entries)
+            return;
+        t->entries = entries;
+        t->entry_capacity = capacity;
+    }
+    struct diff_entry *e = &t->entries[t->entry_count++];
+    strncpy(e->path, path, sizeof(e->path) - 1);
+    e->path[sizeof(e->path) - 1] = '\0';
+    e->size = S_ISDIR(st->st_mode) ? 0 : (long long)st->st_size; // directory sizes are filesystem noise
+    e->mode = st->st_mode;
+}
+
+/**
+ * @brief Record every extracted entry below @p base, relative to the sandbox root.
+ */
+static void list_directory(struct diff_target *t, const char *base, const char *relative, int depth)
+{
+    char path[ENTRY_PATH_LENGTH * 2];
+    snprintf(path, sizeof(path), "%s%s%s", base, relative[0] ? "/" : "", relative);
+    DIR *dir = opendir(path);
+    if (!dir)
+        return;
+    struct dirent *de;
+    char child[ENTRY_PATH_LENGTH * 2];
+    char child_relative[ENTRY_PATH_LENGTH];
+    while ((de = readdir(dir)) != NULL)
+    {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        if (snprintf(child_relative, sizeof(child_relative), "%s%s%s", relative, relative[0] ? "/" : "", de->d_name) >= ENTRY_PATH_LENGTH)
+            continue; // too deep to compare meaningfully
+        snprintf(child, sizeof(child), "%s/%s", base, child_relative);
+        struct stat st;
+        if (lstat(child, &st) == -1)
+            continue;
+        add_entry(t, child_relative, &st);
+        if (S_ISDIR(st.st_mode) && depth < EXEC_MAX_TREE_DEPTH)
+            list_directory(t, base, child_relative, depth + 1);
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Register a reference command, e.g. "tar -xf". The archive path is
+ * appended as the last argument when the target is run.
+ */
+int differential_add_target(const char *command)
+{
+    if (reference_count >= MAX_DIFF_TARGETS - 1)
+    {
+        printf("Too many differential targets (max %d)\n", MAX_DIFF_TARGETS - 1);
+        return -1;
+    }
+    reference_commands[reference_count++] = command;
+    return 0;
+}
+
+/**
+ * @brief Split @p command into the argv of target @p index and give it a sandbox.
+ */
+static int setup_target(int index, const char *command)
+{
+    struct diff_target *t = &targets[index];
+    snprintf(t->command, sizeof(t->command), "%s", command);
+    int argc = exec_split_command(t->command, t->argv, MAX_TARGET_ARGS);
+    if (argc == 0)
+        return -1;
+    // A relative executable path must still resolve from inside the sandbox
+    if (strchr(t->argv[0], '/') && t->argv[0][0] != '/')
+    {
+        char *resolved = realpath(t->argv[0], NULL);
+        if (resolved)
+        {
+            snprintf(t->executable, sizeof(t->executable), "%s", resolved);
+            t->argv[0] = t->executable;
+            free(resolved);
+        }
+    }
+    t->argv[argc++] = archive_path;
+    t->argv[argc] = NULL;
+    snprintf(t->sandbox, sizeof(t->sandbox), "sandbox_%d", index);
+    if (mkdir(t->sandbox, 0755) == -1 && errno != EEXIST)
+    {
+        perror(t->sandbox);
+        return -1;
+    }
+    exec_clear_directory(t->sandbox);
+    printf("Differential target %d: %s\n", index, command);
+    return 0;
+}
+
+static int compare_entries(const void *a, const void *b)
+{
+    return strcmp(((const struct diff_entry *)a)->path, ((const struct diff_entry *)b)->path);
+}
+
+static int accepted(struct exec_result *res)
+{
+    return res->exited && res->exit_code == 0 && !res->crashed;
+}
+
+/**
+ * @brief Compare target @p t against the primary target.
+ *
+ * A crash of the primary target is saved as a crash file and is not a
+ * divergence, and when both reject the archive what each extracted before
+ * giving up is not compared: only accept/reject disagreements and different
+ * extracted trees count.
+ *
+ * @return 1 and a description in @p reason when they diverge.
+ */
+static int diverges(struct diff_target *ref, struct diff_target *t, char *reason, size_t reason_size)
+{
+    if (ref->result.crashed)
+        return 0;
+    if (accepted(&ref->result) != accepted(&t->result))
+    {
+        snprintf(reason, reason_size, "%s %s the archive, %s %s it", ref->argv[0],
+                 accepted(&ref->result) ? "accepts" : "rejects", t->argv[0],
+                 accepted(&t->result) ? "accepts" : "rejects");
+        return 1;
+    }
+    if (!accepted(&ref->result))
+        return 0;
+    size_t n = ref->entry_count < t->entry_count ? ref->entry_count : t->entry_count;
+    for (size_t i = 0; i < n; i++)
+    {
+        struct diff_entry *a = &ref->entries[i], *b = &t->entries[i];
+        if (strcmp(a->path, b->path) != 0)
+        {
+            snprintf(reason, reason_size, "entry name '%s' vs '%s'", a->path, b->path);
+            return 1;
+        }
+        if (a->size != b->size)
+        {
+            snprintf(reason, reason_size, "size of '%s': %lld vs %lld", a->path, a->size, b->size);
+            return 1;
+        }
+        if (a->mode != b->mode)
+        {
+            snprintf(reason, reason_size, "mode of '%s': %06o vs %06o", a->path, a->mode, b->mode);
+            return 1;
+        }
+    }
+    if (ref->entry_count != t->entry_count)
+    {
+        snprintf(reason, reason_size, "%zu extracted entries vs %zu", ref->entry_count, t->entry_count);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Set up differential mode: the extractor under test becomes target 0
+ * and archives are generated into a memfd shared by all targets.
+ */
+int differential_init(const char *extractor_path)
+{
+    if (reference_count == 0)
+        return 0;
+    archive_fd = memfd_create("archive.tar", 0);
+    if (archive_fd == -1)
+    {
+        perror("memfd_create");
+        return -1;
+    }
+    // Every child reopens the memfd through its own fd table, at offset 0
+    snprintf(archive_path, sizeof(archive_path), "/proc/self/fd/%d", archive_fd);
+
+    if (setup_target(0, extractor_path) == -1)
+        return -1;
+    for (int i = 0; i < reference_count; i++)
+    {
+        if (setup_target(i + 1, reference_commands[i]) == -1)
+            return -1;
+    }
+    target_count = reference_count + 1;
+    enabled = 1;
+    return 0;
+}
+
+int differential_enabled(void)
+{
+    return enabled;
+}
+
+/**
+ * @brief Run the current archive through every target concurrently and
+ * compare the outcomes against the extractor under test.
+ * @return 1 if the extractor under test crashed, like run_extractor().
+ */
+int differential_run(void)
+{
+    test_status.number_of_tries++;
+    pid_t pids[MAX_DIFF_TARGETS];
+    struct pollfd fds[MAX_DIFF_TARGETS];
+    int running = 0;
+
+    for (int i = 0; i < target_count; i++)
+    {
+        struct diff_target *t = &targets[i];
+        memset(&t->result, 0, sizeof(struct exec_result));
+        t->entry_count = 0;
+        fds[i].fd = -1;
+        fds[i].events = POLLIN;
+        pids[i] = exec_spawn(t->argv, t->sandbox, -1, &fds[i].fd);
+        if (pids[i] == -1)
+        {
+            printf("Failed to spawn %s: %s\n", t->argv[0], strerror(errno));
+            fds[i].fd = -1;
+            continue;
+        }
+        running++;
+    }
+
+    // Drain all outputs together so the round costs the slowest target, not the sum
+    while (running > 0)
+    {
+        if (poll(fds, target_count, -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i = 0; i < target_count; i++)
+        {
+            if (fds[i].fd == -1 || !(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+                continue;
+            if (!exec_drain(fds[i].fd, &targets[i].result))
+            {
+                close(fds[i].fd);
+                fds[i].fd = -1;
+                running--;
+            }
+        }
+    }
+
+    for (int i = 0; i < target_count; i++)
+    {
+        if (fds[i].fd != -1) // left open by a poll() failure
+            close(fds[i].fd);
+        if (pids[i] == -1)
+            continue;
+        exec_finish(pids[i], &targets[i].result);
+        list_directory(&targets[i], targets[i].sandbox, "", 0);
+        qsort(targets[i].entries, targets[i].entry_count, sizeof(struct diff_entry), compare_entries);
+        exec_clear_directory(targets[i].sandbox);
+    }
+
+    int rv = targets[0].result.crashed;
+    if (rv)
+    {
+        test_status.number_of_success++;
+        char success_name[32];
+        snprintf(success_name, sizeof(success_name), "success_%d.tar", test_status.number_of_success);
+        tar_archive_save(success_name);
+        printf("Saved crash file: %s\n", success_name);
+    }
+    else if (targets[0].result.line_length > 0)
+    {
+        printf("Extractor output: '%s'\n", targets[0].result.first_line);
+    }
+
+    char reason[2 * ENTRY_PATH_LENGTH];
+    for (int i = 1; i < target_count; i++)
+    {
+        if (pids[0] == -1 || pids[i] == -1)
+            continue;
+        if (diverges(&targets[0], &targets[i], reason, sizeof(reason)))
+        {
+            test_status.differential_divergences++;
+            char diverge_name[32];
+            snprintf(diverge_name, sizeof(diverge_name), "diverge_%d.tar", test_status.differential_divergences);
+            tar_archive_save(diverge_name);
+            printf("Divergence with %s: %s (saved %s)\n", targets[i].argv[0], reason, diverge_name);
+            break;
+        }
+    }
+    return rv;
+}
+
+void differential_cleanup(void)
+{
+    for (int i = 0; i < target_count; i++)
+    {
+        if (enabled)
+            rmdir(targets[i].sandbox);
+        free(targets[i].entries);
+        targets[i].entries = NULL;
+    }
+    if (archive_fd != -1)
+        close(archive_fd);
+    archive_fd = -1;
+    enabled = 0;
+}
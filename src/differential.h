@@ -0,0 +1,12 @@
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+#define MAX_DIFF_TARGETS 8
+
+int differential_add_target(const char *command);
+int differential_init(const char *extractor_path);
+int differential_enabled(void);
+int differential_run(void);
+void differential_cleanup(void);
+
+#endif
@@ -0,0 +1,169 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "executor.h"
+
+/**
+ * @brief Fork and exec a target directly, without going through a shell.
+ *
+ * The child runs in @p dir (if not NULL) with stdin taken from @p in_fd (if not
+ * -1), stdout connected to a pipe whose read end is returned in @p out_fd and
+ * stderr sent to /dev/null.
+ */
+pid_t exec_spawn(char *const argv[], const char *dir, int in_fd, int *out_fd)
+{
+    int pipefd[2];
+    // Both ends close-on-exec, or a target spawned meanwhile by another
+    // thread would hold our write end and delay EOF until it exits
+    if (pipe2(pipefd, O_CLOEXEC) == -1)
+        return -1;
+    pid_t pid = fork();
+    if (pid == -1)
+    {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return -1;
+    }
+    if (pid == 0)
+    {
+        close(pipefd[0]);
+        dup2(pipefd[1], STDOUT_FILENO);
+        close(pipefd[1]);
+        if (in_fd != -1 && in_fd != STDIN_FILENO)
+        {
+            dup2(in_fd, STDIN_FILENO);
+            close(in_fd);
+        }
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull != -1)
+        {
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+        if (dir && chdir(dir) == -1)
+            _exit(127);
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+    close(pipefd[1]);
+    *out_fd = pipefd[0];
+    return pid;
+}
+
+/**
+ * @brief Read whatever output is available, keeping only the first line.
+ * @return 1 while the pipe is still open, 0 on EOF or error.
+ */
+int exec_drain(int out_fd, struct exec_result *res)
+{
+    char buf[4096];
+    ssize_t n = read(out_fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+        return 1;
+    if (n <= 0)
+        return 0;
+    for (ssize_t i = 0; i < n && !res->line_complete; i++)
+    {
+        if (res->line_length < sizeof(res->first_line) - 1)
+            res->first_line[res->line_length++] = buf[i];
+        if (buf[i] == '\n')
+            res->line_complete = 1;
+    }
+    res->first_line[res->line_length] = '\0';
+    return 1;
+}
+
+/**
+ * @brief Reap the child and fill in how it terminated.
+ */
+int exec_finish(pid_t pid, struct exec_result *res)
+{
+    int status;
+    while (waitpid(pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+            return -1;
+    }
+    res->exited = WIFEXITED(status);
+    res->exit_code = res->exited ? WEXITSTATUS(status) : 0;
+    res->signaled = WIFSIGNALED(status);
+    res->signal = res->signaled ? WTERMSIG(status) : 0;
+    res->crashed = strncmp(res->first_line, CRASH_MESSAGE, sizeof(CRASH_MESSAGE)) == 0;
+    return 0;
+}
+
+/**
+ * @brief Spawn a target and wait for it, collecting its first output line.
+ */
+int exec_run(char *const argv[], const char *dir, struct exec_result *res)
+{
+    memset(res, 0, sizeof(struct exec_result));
+    int out_fd;
+    pid_t pid = exec_spawn(argv, dir, -1, &out_fd);
+    if (pid == -1)
+        return -1;
+    while (exec_drain(out_fd, res))
+        ;
+    close(out_fd);
+    return exec_finish(pid, res);
+}
+
+/**
+ * @brief Split a command line on blanks into @p argv (at most @p max words).
+ * @return Number of words; argv[argc] is left for the caller to terminate.
+ */
+int exec_split_command(char *command, char **argv, int max)
+{
+    int argc = 0;
+    for (char *word = strtok(command, " \t"); word && argc < max; word = strtok(NULL, " \t"))
+        argv[argc++] = word;
+    return argc;
+}
+
+/**
+ * @brief Empty a sandbox directory, descending into subdirectories.
+ */
+static void clear_directory(const char *path, int depth)
+{
+    DIR *dir = opendir(path);
+    if (!dir)
+        return;
+    struct dirent *de;
+    char child[PATH_MAX];
+    while ((de = readdir(dir)) != NULL)
+    {
+        if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+            continue;
+        snprintf(child, sizeof(child), "%s/%s", path, de->d_name);
+        struct stat st;
+        if (lstat(child, &st) == -1)
+            continue;
+        if (S_ISDIR(st.st_mode) && depth < EXEC_MAX_TREE_DEPTH)
+        {
+            chmod(child, 0700); // extracted dirs may come without write/search permission
+            clear_directory(child, depth + 1);
+            rmdir(child);
+        }
+        else
+        {
+            unlink(child);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * @brief Remove everything a target extracted into its sandbox directory.
+ */
+void exec_clear_directory(const char *path)
+{
+    clear_directory(path, 0);
+}
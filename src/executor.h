@@ -0,0 +1,29 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+#include <stddef.h>
+#include <sys/types.h>
+
+#define CRASH_MESSAGE "*** The program has crashed ***\n"
+#define EXEC_LINE_LENGTH 128
+#define EXEC_MAX_TREE_DEPTH 32
+
+struct exec_result
+{
+    int exited;    /* child terminated through exit() */
+    int exit_code; /* valid when exited */
+    int signaled;  /* child was killed by a signal */
+    int signal;    /* valid when signaled */
+    int crashed;   /* first line of output is CRASH_MESSAGE */
+    char first_line[EXEC_LINE_LENGTH];
+    size_t line_length; /* bytes of first_line collected so far */
+    int line_complete;
+};
+
+pid_t exec_spawn(char *const argv[], const char *dir, int in_fd, int *out_fd);
+int exec_drain(int out_fd, struct exec_result *res);
+int exec_finish(pid_t pid, struct exec_result *res);
+int exec_run(char *const argv[], const char *dir, struct exec_result *res);
+int exec_split_command(char *command, char **argv, int max);
+void exec_clear_directory(const char *path);
+
+#endif
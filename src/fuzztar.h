@@ -0,0 +1,22 @@
+#ifndef FUZZTAR_H
+#define FUZZTAR_H
+
+/* Public API of libfuzztar: header templates and incremental checksums,
+ * numeric field encoding, archive assembly, tar-aware mutators, crossover,
+ * covering arrays, dictionaries extracted from a target binary and the
+ * block-alignment sweep. None of it touches global mutable state besides
+ * the templates, which are built once under pthread_once() by the first
+ * call that needs them, or by tar_templates_init(), and read-only
+ * afterwards, so any thread may call into the library. Link with -pthread. */
+
+#include "constants.h"
+#include "template.h"
+#include "numfield.h"
+#include "archive.h"
+#include "mutate.h"
+#include "crossover.h"
+#include "covering.h"
+#include "dictionary.h"
+#include "sweep.h"
+
+#endif
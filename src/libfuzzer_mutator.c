@@ -0,0 +1,41 @@
+#include <stddef.h>
+#include <stdint.h>
+#include "mutate.h"
+#include "crossover.h"
+
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed);
+size_t LLVMFuzzerCustomCrossOver(const uint8_t *data1, size_t size1, const uint8_t *data2, size_t size2, uint8_t *out,
+                                 size_t max_out_size, unsigned int seed);
+
+/**
+ * @brief libFuzzer custom mutator: tar-aware mutations for any linked-in parser.
+ *
+ * Link this object (or libfuzztar.a with --whole-archive) into a libFuzzer
+ * harness and its LLVMFuzzerTestOneInput() receives archives mutated at
+ * header-field granularity with valid checksums, instead of random bytes.
+ * All state lives on the stack, seeded by libFuzzer, so runs are reproducible.
+ */
+size_t LLVMFuzzerCustomMutator(uint8_t *data, size_t size, size_t max_size, unsigned int seed)
+{
+    struct tar_mutator m;
+    tar_mutator_init(&m, seed);
+    return tar_mutate_archive(&m, data, size, max_size);
+}
+
+/**
+ * @brief libFuzzer custom crossover: splice whole entries of two archives.
+ *
+ * Cuts only fall on entry boundaries, so every header of the child is a
+ * header of one of the parents and the checksums stay valid.
+ */
+size_t LLVMFuzzerCustomCrossOver(const uint8_t *data1, size_t size1, const uint8_t *data2, size_t size2, uint8_t *out,
+                                 size_t max_out_size, unsigned int seed)
+{
+    struct tar_mutator m;
+    struct tar_archive child;
+    tar_mutator_init(&m, seed);
+    tar_archive_wrap(&child, out, 0, max_out_size);
+    if (tar_crossover_archive(&m, &child, (const char *)data1, size1, (const char *)data2, size2, SIZE_MAX) == -1)
+        return 0;
+    return child.length;
+}
@@ -3,42 +3,127 @@
 #include <string.h>
 #include <time.h>
 #include <limits.h>
+#include <stddef.h>
+#include <unistd.h>
 #include "utils.h"
+#include "differential.h"
+#include "stream.h"
+#include "numfield.h"
+#include "mutate.h"
+#include "corpus.h"
+#include "crossover.h"
+#include "covering.h"
+#include "pipeline.h"
+#include "snapshot.h"
+#include "dictionary.h"
+#include "sweep.h"
 
 static char *extractor_path;
+static struct corpus seeds;
+static struct tar_dictionary dictionary;
+
+#define SEED_MUTATIONS 3                    /* mutated runs per seed entry, after the unmodified one */
+#define SEED_CONTENT_LIMIT (64 * 1024)      /* seed payload bytes written, the rest of the payload is a hole */
+#define CROSSOVER_RUNS 256                  /* children bred from the seeds and this run's crash files */
+#define CROSSOVER_BATCH 16                  /* children built in the arena before any is run */
+#define CROSSOVER_ENTRIES 64                /* headers of a parent considered for header crossover */
+#define CROSSOVER_PAYLOAD_LIMIT (64 * 1024) /* payload bytes copied per entry, whatever its size says */
+
+/* A value class of one header field for the combinatorial stage: keep the
+ * template value, fill the whole field with one byte, or write a literal
+ * (the rest of the field is zeroed, as snprintf would leave it). */
+struct value_class
+{
+    const char *data;
+    size_t length;
+    char fill;
+};
+
+#define KEEP {NULL, 0, 0}
+#define FILL(c) {NULL, 0, c}
+#define LITERAL(s) {s, sizeof(s) - 1, 0}
+#define FIELD(f) #f, offsetof(tar_header, f), sizeof(((tar_header *)0)->f)
+
+/* The values the single-field stages above try, one row per field */
+static const struct
+{
+    const char *name;
+    size_t offset;
+    size_t width;
+    unsigned char count;
+    struct value_class values[4];
+} field_classes[] = {
+    {FIELD(name), 4, {KEEP, FILL('\xFF'), FILL('A'), LITERAL("\x01\xFFinvalid\x00path")}},
+    {FIELD(mode), 4, {KEEP, LITERAL("07777"), LITERAL("ABCDEF"), FILL('9')}},
+    {FIELD(uid), 4, {KEEP, FILL('9'), LITERAL("-000001"), LITERAL("ABCDEF")}},
+    {FIELD(gid), 4, {KEEP, FILL('9'), LITERAL("-000001"), LITERAL("GIDJUN")}},
+    {FIELD(size), 4, {KEEP, LITERAL("00000000001"), LITERAL("77777777777"), LITERAL("-2147483648")}},
+    {FIELD(mtime), 4, {KEEP, LITERAL("99999999999"), LITERAL("FFFFFFF"), LITERAL("-ABCDEF")}},
+    {FIELD(chksum), 4, {KEEP, LITERAL("7777777"), LITERAL("XYZ123"), LITERAL("123456")}},
+    {FIELD(typeflag), 4, {KEEP, LITERAL("2"), LITERAL("\x92"), LITERAL("\xFF")}},
+    {FIELD(linkname), 4, {KEEP, FILL('\xFF'), FILL('L'), LITERAL("/invalid/path")}},
+    {FIELD(magic), 4, {KEEP, LITERAL("BADMA"), FILL('\xFF'), LITERAL("ust")}},
+    {FIELD(version), 4, {KEEP, LITERAL("77"), LITERAL("0"), FILL('\xFF')}},
+    {FIELD(uname), 4, {KEEP, FILL('\xFF'), FILL('U'), LITERAL("\x00user\xFFjunk")}},
+    {FIELD(gname), 3, {KEEP, FILL('\xFF'), FILL('G')}},
+    {FIELD(devmajor), 3, {KEEP, FILL('9'), LITERAL("-000001")}},
+    {FIELD(devminor), 3, {KEEP, FILL('9'), LITERAL("-000001")}},
+    {FIELD(prefix), 3, {KEEP, FILL('\xFF'), FILL('P')}},
+};
+
+#define CLASS_FIELD_COUNT (sizeof(field_classes) / sizeof(field_classes[0]))
+#define CHKSUM_CLASS 6
+
+/* Whole-field writes on a tar_case, as memset() and snprintf(..., "%s", ...)
+ * did on a bare header: the checksum follows without being recomputed */
+#define CASE_FILL(tc, field, c) tar_case_fill((tc), offsetof(tar_header, field), (c), sizeof(((tar_header *)0)->field))
+#define CASE_PRINT(tc, field, s) case_print((tc), offsetof(tar_header, field), sizeof(((tar_header *)0)->field), (s))
+
+/**
+ * @brief Write @p s and its NUL at @p offset, truncated to @p width like
+ * snprintf(); the rest of the field keeps its bytes.
+ */
+static void case_print(struct tar_case *tc, size_t offset, size_t width, const char *s)
+{
+    size_t length = strlen(s);
+    if (length > width - 1)
+        length = width - 1;
+    tar_case_patch(tc, offset, s, length);
+    tar_case_set_byte(tc, offset + length, '\0');
+}
 
 /**
  * @brief Fuzz the 'name' field with aggressive edge cases.
  */
 void fuzz_name()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Name +++\n");
 
     // Test 1: Overflow with prefix and invalid typeflag
-    memset(header.name, '\xFF', sizeof(header.name));
-    memset(header.prefix, '\xFF', sizeof(header.prefix));
-    header.typeflag = '\x92'; // Non-standard type
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, name, '\xFF');
+    CASE_FILL(&tc, prefix, '\xFF');
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), '\x92'); // Non-standard type
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.name_fuzzing_success++;
 
     // Test 2: Junk with no null and content
-    memset(header.name, 'A', sizeof(header.name));
-    header.name[0] = '\x01';
-    header.name[sizeof(header.name) - 1] = '\xFF';
-    snprintf(header.size, sizeof(header.size), "00000000001");
+    CASE_FILL(&tc, name, 'A');
+    tar_case_set_byte(&tc, offsetof(tar_header, name), '\x01');
+    tar_case_set_byte(&tc, offsetof(tar_header, name) + sizeof(tc.header.name) - 1, '\xFF');
+    CASE_PRINT(&tc, size, "00000000001");
     char content[] = "X";
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.name_fuzzing_success++;
 
     // Test 3: Embedded nulls with huge size
     const char junk[] = "\x01\xFFinvalid\x00path";
-    memcpy(header.name, junk, sizeof(junk) < sizeof(header.name) ? sizeof(junk) : sizeof(header.name));
-    snprintf(header.size, sizeof(header.size), "77777777777");
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    TAR_CASE_PATCH(&tc, name, junk, sizeof(junk) < sizeof(tc.header.name) ? sizeof(junk) : sizeof(tc.header.name));
+    CASE_PRINT(&tc, size, "77777777777");
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.name_fuzzing_success++;
 
@@ -49,25 +134,25 @@ void fuzz_name()
  */
 void fuzz_mode()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Mode +++\n");
 
     // Test 1: Max octal permissions
-    snprintf(header.mode, sizeof(header.mode), "07777");
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, mode, "07777");
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.mode_fuzzing_success++;
 
     // Test 2: Non-octal mode
-    snprintf(header.mode, sizeof(header.mode), "ABCDEF");
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, mode, "ABCDEF");
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.mode_fuzzing_success++;
 
     // Test 3: Overflow mode
-    memset(header.mode, '9', sizeof(header.mode));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, mode, '9');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.mode_fuzzing_success++;
 
@@ -79,22 +164,22 @@ void fuzz_mode()
  */
 void fuzz_uid()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing UID +++\n");
 
-    memset(header.uid, '9', sizeof(header.uid));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, uid, '9');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uid_fuzzing_success++;
 
-    snprintf(header.uid, sizeof(header.uid), "-000001"); // 7 bytes + null
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, uid, "-000001"); // 7 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uid_fuzzing_success++;
 
-    snprintf(header.uid, sizeof(header.uid), "ABCDEF"); // 6 bytes + null
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, uid, "ABCDEF"); // 6 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uid_fuzzing_success++;
 
@@ -106,22 +191,22 @@ void fuzz_uid()
  */
 void fuzz_gid()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing GID +++\n");
 
-    memset(header.gid, '9', sizeof(header.gid));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, gid, '9');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.gid_fuzzing_success++;
 
-    snprintf(header.gid, sizeof(header.gid), "-000001"); // 7 bytes + null
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, gid, "-000001"); // 7 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.gid_fuzzing_success++;
 
-    snprintf(header.gid, sizeof(header.gid), "GIDJUN"); // 6 bytes + null
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, gid, "GIDJUN"); // 6 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.gid_fuzzing_success++;
 
@@ -133,12 +218,12 @@ void fuzz_gid()
  */
 void fuzz_size()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
     printf("\n+++ Fuzzing Size +++\n");
 
     char content[] = "This is a test file content.";
     size_t content_size = sizeof(content);
+    char size_field[12];
     int num_tries = 10;
     int possible_sizes[num_tries];
     srand(time(NULL));
@@ -148,17 +233,19 @@ void fuzz_size()
     }
     for (int i = 0; i < num_tries; i++)
     {
-        tar_init_header(&header);
+        tar_case_init(&tc, header_template);
         char end_data[BLOCK_SIZE] = {0};
-        snprintf(header.size, sizeof(header.size), "%o", possible_sizes[i]);
-        tar_generate(&header, content, content_size, end_data, BLOCK_SIZE);
+        num_encode(size_field, sizeof(size_field), possible_sizes[i], NUM_OCTAL_MINIMAL);
+        TAR_CASE_PATCH(&tc, size, size_field, sizeof(size_field));
+        tar_generate_case(&tc, content, content_size, end_data, BLOCK_SIZE);
         if (run_extractor(extractor_path))
             test_status.size_fuzzing_success++;
     }
-    tar_init_header(&header);
-    snprintf(header.size, sizeof(header.size), "%d", INT_MIN);
+    tar_case_init(&tc, header_template);
+    snprintf(size_field, sizeof(size_field), "%d", INT_MIN);
+    CASE_PRINT(&tc, size, size_field);
     char end_data[BLOCK_SIZE] = {0};
-    tar_generate(&header, content, content_size, end_data, BLOCK_SIZE);
+    tar_generate_case(&tc, content, content_size, end_data, BLOCK_SIZE);
     if (run_extractor(extractor_path))
         test_status.size_fuzzing_success++;
 
@@ -170,23 +257,22 @@ void fuzz_size()
  */
 void fuzz_mtime()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Mtime +++\n");
 
     // Test 1: Extreme overflow with valid checksum
-    snprintf(header.mtime, sizeof(header.mtime), "99999999999");
-    tar_compute_checksum(&header);
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, mtime, "99999999999");
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.mtime_fuzzing_success++;
 
-    // Test 2: Non-octal with multi-file
-    snprintf(header.mtime, sizeof(header.mtime), "FFFFFFF");
-    FILE *fp = fopen("archive.tar", "wb");
-    fwrite(&header, sizeof(tar_header), 1, fp);
-    tar_init_header(&header);
-    fwrite(&header, sizeof(tar_header), 1, fp);
+    // Test 2: Non-octal with multi-file, the first header keeping the checksum of test 1
+    CASE_PRINT(&tc, mtime, "FFFFFFF");
+    FILE *fp = tar_archive_open();
+    fwrite(&tc.header, sizeof(tar_header), 1, fp);
+    tar_case_init(&tc, header_template);
+    fwrite(&tc.header, sizeof(tar_header), 1, fp);
     char end[END_BYTES] = {0};
     fwrite(end, END_BYTES, 1, fp);
     fclose(fp);
@@ -195,10 +281,10 @@ void fuzz_mtime()
         test_status.mtime_fuzzing_success++;
 
     // Test 3: Negative with content
-    snprintf(header.mtime, sizeof(header.mtime), "-ABCDEF");
-    snprintf(header.size, sizeof(header.size), "00000000001");
+    CASE_PRINT(&tc, mtime, "-ABCDEF");
+    CASE_PRINT(&tc, size, "00000000001");
     char content[] = "Y";
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.mtime_fuzzing_success++;
 
@@ -210,26 +296,26 @@ void fuzz_mtime()
  */
 void fuzz_chksum()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Checksum +++\n");
     update_checksum = 0;
 
-    tar_compute_checksum(&header);
-    header.chksum[0] = '1';
-    tar_generate_empty(&header);
+    tar_case_finalize(&tc);
+    tar_case_set_byte(&tc, offsetof(tar_header, chksum), '1');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.checksum_fuzzing_success++;
 
-    snprintf(header.chksum, sizeof(header.chksum), "7777777"); // 7 bytes + null
-    snprintf(header.size, sizeof(header.size), "00000000001");
+    CASE_PRINT(&tc, chksum, "7777777"); // 7 bytes + null
+    CASE_PRINT(&tc, size, "00000000001");
     char content[] = "Z";
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.checksum_fuzzing_success++;
 
-    snprintf(header.chksum, sizeof(header.chksum), "XYZ123"); // 6 bytes + null
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    CASE_PRINT(&tc, chksum, "XYZ123"); // 6 bytes + null
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.checksum_fuzzing_success++;
 
@@ -242,26 +328,26 @@ void fuzz_chksum()
  */
 void fuzz_typeflag()
 {
-    tar_header header;
-    tar_init_header(&header);
     printf("\n+++ Fuzzing Typeflag +++\n");
     int prev_success = test_status.number_of_success;
 
+    struct tar_case tc;
+    char end_data[END_BYTES] = {0};
     for (int i = 0; i < 256; i++)
     {
-        tar_init_header(&header);
-        header.typeflag = (char)i;
-        tar_generate_empty(&header);
+        tar_case_init(&tc, header_template);
+        tar_case_set_byte(&tc, offsetof(tar_header, typeflag), (char)i);
+        tar_generate_case(&tc, NULL, 0, end_data, END_BYTES);
         run_extractor(extractor_path);
     }
-    tar_init_header(&header);
-    header.typeflag = -1;
-    tar_generate_empty(&header);
+    tar_case_init(&tc, header_template);
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), -1);
+    tar_generate_case_empty(&tc);
     run_extractor(extractor_path);
 
-    tar_init_header(&header);
-    header.typeflag = '\xFF'; // Max single-byte value (intended overflow test)
-    tar_generate_empty(&header);
+    tar_case_init(&tc, header_template);
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), '\xFF'); // Max single-byte value (intended overflow test)
+    tar_generate_case_empty(&tc);
     run_extractor(extractor_path);
 
     test_status.typeflag_fuzzing_success = test_status.number_of_success - prev_success;
@@ -273,29 +359,27 @@ void fuzz_typeflag()
  */
 void fuzz_linkname()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Linkname +++\n");
 
     // Test 1: Overflow linkname
-    memset(header.linkname, '\xFF', sizeof(header.linkname));
-    header.typeflag = SYMTYPE; // Symbolic link
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, linkname, '\xFF');
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), SYMTYPE); // Symbolic link
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.linkname_fuzzing_success++;
 
     // Test 2: No null terminator
-    memset(header.linkname, 'L', sizeof(header.linkname));
-    header.typeflag = SYMTYPE;
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, linkname, 'L');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.linkname_fuzzing_success++;
 
     // Test 3: Invalid link with content
-    snprintf(header.linkname, sizeof(header.linkname), "/invalid/path");
-    header.typeflag = SYMTYPE;
+    CASE_PRINT(&tc, linkname, "/invalid/path");
     char content[] = "Link content";
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.linkname_fuzzing_success++;
 
@@ -307,26 +391,25 @@ void fuzz_linkname()
  */
 void fuzz_magic()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Magic +++\n");
 
-    snprintf(header.magic, sizeof(header.magic), "BADMA"); // 5 bytes + null
-    tar_compute_checksum(&header);
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, magic, "BADMA"); // 5 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.magic_fuzzing_success++;
 
-    memset(header.magic, '\xFF', sizeof(header.magic));
-    snprintf(header.size, sizeof(header.size), "00000000001");
+    CASE_FILL(&tc, magic, '\xFF');
+    CASE_PRINT(&tc, size, "00000000001");
     char content[] = "M";
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.magic_fuzzing_success++;
 
-    snprintf(header.magic, sizeof(header.magic), "ust"); // 3 bytes + null
-    snprintf(header.size, sizeof(header.size), "77777777777");
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    CASE_PRINT(&tc, magic, "ust"); // 3 bytes + null
+    CASE_PRINT(&tc, size, "77777777777");
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.magic_fuzzing_success++;
 
@@ -342,6 +425,8 @@ void fuzz_version()
     tar_init_header(&header);
     printf("\n+++ Fuzzing Version +++\n");
 
+    struct tar_case tc;
+    char end_data[END_BYTES] = {0};
     char octal[3] = {'0', '0', '\0'};
     for (int i = 0; i < 8; i++)
     {
@@ -349,9 +434,9 @@ void fuzz_version()
         for (int j = 0; j < 8; j++)
         {
             octal[1] = j + '0';
-            tar_init_header(&header);
-            memcpy(header.version, octal, sizeof(header.version)); // Fixed
-            tar_generate_empty(&header);
+            tar_case_init(&tc, header_template);
+            TAR_CASE_PATCH(&tc, version, octal, sizeof(header.version));
+            tar_generate_case(&tc, NULL, 0, end_data, END_BYTES);
             if (run_extractor(extractor_path))
                 test_status.version_fuzzing_success++;
         }
@@ -364,26 +449,26 @@ void fuzz_version()
  */
 void fuzz_uname()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Uname +++\n");
 
     // Test 1: Overflow uname
-    memset(header.uname, '\xFF', sizeof(header.uname));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, uname, '\xFF');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uname_fuzzing_success++;
 
     // Test 2: No null terminator
-    memset(header.uname, 'U', sizeof(header.uname));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, uname, 'U');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uname_fuzzing_success++;
 
     // Test 3: Junk with nulls
     const char junk[] = "\x00user\xFFjunk";
-    memcpy(header.uname, junk, sizeof(junk) < sizeof(header.uname) ? sizeof(junk) : sizeof(header.uname));
-    tar_generate_empty(&header);
+    TAR_CASE_PATCH(&tc, uname, junk, sizeof(junk) < sizeof(tc.header.uname) ? sizeof(junk) : sizeof(tc.header.uname));
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uname_fuzzing_success++;
 
@@ -395,34 +480,66 @@ void fuzz_uname()
  */
 void fuzz_gname()
 {
-    tar_header header;
-    tar_init_header(&header);
     printf("\n+++ Fuzzing Gname +++\n");
 
     printf("+++ Gname Fuzzing Done +++\n");
 }
 
+/**
+ * @brief Fuzz every numeric field with each encoding at the field max and max +/- 1.
+ */
+void fuzz_numeric()
+{
+    printf("\n+++ Fuzzing Numeric Fields +++\n");
+    struct tar_case tc;
+    char end_data[END_BYTES] = {0};
+    char field[12];
+    unsigned long long values[3];
+
+    for (int f = 0; f < NUM_FIELD_COUNT; f++)
+    {
+        if (num_fields[f].offset == CHKSUM_OFFSET)
+            continue; // rewritten by tar_generate_case(); fuzz_chksum() covers it
+        for (int fmt = 0; fmt < NUM_FORMAT_COUNT; fmt++)
+        {
+            int count = num_edge_values(num_fields[f].width, fmt, values);
+            for (int v = 0; v < count; v++)
+            {
+                tar_case_init(&tc, header_template);
+                num_encode(field, num_fields[f].width, values[v], fmt);
+                tar_case_patch(&tc, num_fields[f].offset, field, num_fields[f].width);
+                tar_generate_case(&tc, NULL, 0, end_data, END_BYTES);
+                if (run_extractor(extractor_path))
+                    test_status.numeric_fuzzing_success++;
+            }
+        }
+    }
+    printf("+++ Numeric Fuzzing Done +++\n");
+}
+
 /**
  * @brief Fuzz the content size of the tar archive.
  */
 void fuzz_huge_content()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Huge Content +++\n");
 
     // Test 1: 1MB content
     char content[1024 * 1024]; // 1MB
     memset(content, 'X', sizeof(content));
-    snprintf(header.size, sizeof(header.size), "%lo", (unsigned long)sizeof(content));
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    char size_field[12];
+    num_encode(size_field, sizeof(size_field), sizeof(content), NUM_OCTAL_MINIMAL);
+    TAR_CASE_PATCH(&tc, size, size_field, sizeof(size_field));
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.huge_content_fuzzing_success++; // Fixed
 
     // Test 2: Huge size with short content
-    snprintf(header.size, sizeof(header.size), "77777777777");
+    CASE_PRINT(&tc, size, "77777777777");
     char short_content[] = "Short";
-    tar_generate(&header, short_content, sizeof(short_content), NULL, 0);
+    tar_generate_case(&tc, short_content, sizeof(short_content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.huge_content_fuzzing_success++; // Fixed
 
@@ -434,19 +551,19 @@ void fuzz_huge_content()
  */
 void fuzz_prefix()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Prefix +++\n");
 
     // Test 1: Overflow prefix
-    memset(header.prefix, '\xFF', sizeof(header.prefix));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, prefix, '\xFF');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.prefix_fuzzing_success++; // Fixed
 
     // Test 2: No null terminator
-    memset(header.prefix, 'P', sizeof(header.prefix));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, prefix, 'P');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.prefix_fuzzing_success++; // Fixed
 
@@ -458,20 +575,20 @@ void fuzz_prefix()
  */
 void fuzz_padding_footer()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Padding and Footer +++\n");
 
     // Test 1: Corrupted padding
-    memset(header.padding, '\xFF', sizeof(header.padding));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, padding, '\xFF');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.size_fuzzing_success++; // Tied to size handling
 
     // Test 2: Oversized footer
     char huge_end[END_BYTES * 2];
     memset(huge_end, '\xAA', sizeof(huge_end));
-    tar_generate(&header, NULL, 0, huge_end, sizeof(huge_end));
+    tar_generate_case(&tc, NULL, 0, huge_end, sizeof(huge_end));
     if (run_extractor(extractor_path))
         test_status.end_of_file_fuzzing_success++;
 
@@ -483,26 +600,27 @@ void fuzz_padding_footer()
  */
 void fuzz_combo()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Combo +++\n");
 
     // Test 1: Name + size + typeflag
-    memset(header.name, '\xFF', sizeof(header.name));
-    snprintf(header.size, sizeof(header.size), "99999999999");
-    header.typeflag = '\x90';
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, name, '\xFF');
+    CASE_PRINT(&tc, size, "99999999999");
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), '\x90');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.name_fuzzing_success++;
 
     // Test 2: Linkname + prefix + chksum
     update_checksum = 0;
-    tar_init_header(&header);
-    memset(header.linkname, '\xFF', sizeof(header.linkname));
-    memset(header.prefix, '\xFF', sizeof(header.prefix));
-    snprintf(header.chksum, sizeof(header.chksum), "123456");
-    header.typeflag = SYMTYPE;
-    tar_generate_empty(&header);
+    tar_case_init(&tc, header_template);
+    CASE_FILL(&tc, chksum, '\0');
+    CASE_FILL(&tc, linkname, '\xFF');
+    CASE_FILL(&tc, prefix, '\xFF');
+    CASE_PRINT(&tc, chksum, "123456");
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), SYMTYPE);
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.linkname_fuzzing_success++;
     update_checksum = 1;
@@ -510,13 +628,183 @@ void fuzz_combo()
     printf("+++ Combo Fuzzing Done +++\n");
 }
 
+/**
+ * @brief Set one field of @p tc to value class @p level of field_classes[@p f].
+ */
+static void apply_value_class(struct tar_case *tc, size_t f, unsigned char level)
+{
+    const struct value_class *v = &field_classes[f].values[level];
+    char value[sizeof(tar_header)];
+    if (!v->data && !v->fill)
+        return;
+    memset(value, v->data ? 0 : v->fill, field_classes[f].width);
+    if (v->data)
+        memcpy(value, v->data, v->length < field_classes[f].width ? v->length : field_classes[f].width);
+    tar_case_patch(tc, field_classes[f].offset, value, field_classes[f].width);
+}
+
+/**
+ * @brief Combine the single-field value classes with a t-way covering array.
+ *
+ * Every combination of values of any @p strength fields shows up in at
+ * least one archive, which takes a few hundred archives where the full
+ * cross product would take billions. The chksum class is applied after the
+ * checksum is computed, so only its KEEP class yields a valid one.
+ */
+void fuzz_covering(int strength)
+{
+    printf("\n+++ Fuzzing Covering Array +++\n");
+    unsigned char levels[CLASS_FIELD_COUNT];
+    for (size_t f = 0; f < CLASS_FIELD_COUNT; f++)
+        levels[f] = field_classes[f].count;
+
+    struct tar_mutator m;
+    tar_mutator_init(&m, (unsigned long long)time(NULL));
+    struct covering_array ca;
+    if (covering_array_build(&ca, levels, CLASS_FIELD_COUNT, strength, &m) == -1)
+    {
+        printf("Unable to build a %d-way covering array\n", strength);
+        return;
+    }
+    printf("%d-way covering array: %zu archives cover %zu tuples of %zu fields\n", strength, ca.rows, ca.tuples,
+           CLASS_FIELD_COUNT);
+
+    struct tar_case tc;
+    static char content[BLOCK_SIZE];
+    static char end_data[BLOCK_SIZE + END_BYTES];
+    memset(content, 'C', sizeof(content));
+    update_checksum = 0;
+    for (size_t r = 0; r < ca.rows; r++)
+    {
+        const unsigned char *row = covering_array_row(&ca, r);
+        tar_case_init(&tc, header_template);
+        for (size_t f = 0; f < CLASS_FIELD_COUNT; f++)
+        {
+            if (f != CHKSUM_CLASS)
+                apply_value_class(&tc, f, row[f]);
+        }
+        tar_case_finalize(&tc);
+        apply_value_class(&tc, CHKSUM_CLASS, row[CHKSUM_CLASS]);
+
+        unsigned long long declared = num_decode(tc.header.size, sizeof(tc.header.size));
+        size_t content_size = declared < BLOCK_SIZE ? (size_t)declared : BLOCK_SIZE;
+        size_t padding = (BLOCK_SIZE - content_size % BLOCK_SIZE) % BLOCK_SIZE;
+        tar_generate_case(&tc, content, content_size, end_data, padding + END_BYTES);
+        if (run_extractor(extractor_path))
+            test_status.covering_fuzzing_success++;
+    }
+    update_checksum = 1;
+    covering_array_free(&ca);
+    printf("+++ Covering Array Fuzzing Done +++\n");
+}
+
+/**
+ * @brief Write a header with one field changed, plus a payload of the
+ * declared size (capped at a block) and the end marker, and run it.
+ */
+static int run_dictionary_case(struct tar_case *tc)
+{
+    static char content[BLOCK_SIZE];
+    static char end_data[BLOCK_SIZE + END_BYTES];
+    memset(content, 'D', sizeof(content));
+    tar_case_finalize(tc);
+    unsigned long long declared = num_decode(tc->header.size, sizeof(tc->header.size));
+    size_t content_size = declared < BLOCK_SIZE ? (size_t)declared : BLOCK_SIZE;
+    size_t padding = (BLOCK_SIZE - content_size % BLOCK_SIZE) % BLOCK_SIZE;
+    tar_generate_case(tc, content, content_size, end_data, padding + END_BYTES);
+    return run_extractor(extractor_path);
+}
+
+/**
+ * @brief Try every literal found in the extractor binary in every field.
+ *
+ * Each token is written NUL-padded into each field it fits, numeric fields
+ * included since "0" or "46" may be compared there as much as in the magic.
+ * Each value the code compares with, and its neighbours on both sides, is
+ * written as octal into each numeric field but chksum.
+ */
+void fuzz_dictionary()
+{
+    printf("\n+++ Fuzzing Dictionary +++\n");
+    struct tar_case tc;
+    char value[155];
+    for (size_t t = 0; t < dictionary.token_count; t++)
+    {
+        const struct tar_token *token = &dictionary.tokens[t];
+        for (size_t f = 0; f < CLASS_FIELD_COUNT; f++)
+        {
+            if (f == CHKSUM_CLASS || token->length > field_classes[f].width)
+                continue;
+            tar_case_init(&tc, header_template);
+            memset(value, 0, field_classes[f].width);
+            memcpy(value, token->bytes, token->length);
+            tar_case_patch(&tc, field_classes[f].offset, value, field_classes[f].width);
+            if (run_dictionary_case(&tc))
+                test_status.dictionary_fuzzing_success++;
+        }
+    }
+    for (size_t v = 0; v < dictionary.value_count; v++)
+    {
+        for (size_t f = 0; f < NUM_FIELD_COUNT; f++)
+        {
+            if (num_fields[f].offset == CHKSUM_OFFSET)
+                continue;
+            for (int delta = -1; delta <= 1; delta++)
+            {
+                tar_case_init(&tc, header_template);
+                num_encode(value, num_fields[f].width, dictionary.values[v] + delta, NUM_OCTAL_NUL);
+                tar_case_patch(&tc, num_fields[f].offset, value, num_fields[f].width);
+                if (run_dictionary_case(&tc))
+                    test_status.dictionary_fuzzing_success++;
+            }
+        }
+    }
+    printf("+++ Dictionary Fuzzing Done +++\n");
+}
+
+/**
+ * @brief Sweep the size field, payload length, padding and end marker
+ * around block boundaries up to @p limit bytes, see tar_sweep_next().
+ *
+ * Payloads are the template's own header block repeated, so a parser that
+ * loses track of the size lands on valid-looking headers, and sparse
+ * payloads, padding and end markers are holes. Only payloads of a few
+ * blocks are written in full, so a point costs about the same whatever its
+ * sizes.
+ */
+void fuzz_sweep(unsigned long long limit)
+{
+    printf("\n+++ Fuzzing Size Sweep +++\n");
+    struct tar_case segment;
+    tar_case_init(&segment, header_template);
+    tar_case_finalize(&segment);
+
+    struct tar_sweep sweep;
+    struct tar_sweep_point point;
+    struct tar_case tc;
+    char size_field[12];
+    size_t archives = 0;
+    tar_sweep_init(&sweep, limit);
+    while (tar_sweep_next(&sweep, &point))
+    {
+        tar_case_init(&tc, header_template);
+        num_encode(size_field, sizeof(size_field), point.declared, NUM_OCTAL_NUL);
+        TAR_CASE_PATCH(&tc, size, size_field, sizeof(size_field));
+        tar_generate_segments(&tc, (const char *)&segment.header, BLOCK_SIZE, point.content, point.zeros);
+        if (run_extractor(extractor_path))
+            test_status.sweep_fuzzing_success++;
+        archives++;
+    }
+    printf("Swept %zu archives up to %llu bytes\n", archives, limit);
+    printf("+++ Size Sweep Fuzzing Done +++\n");
+}
+
 /**
  * @brief Fuzz the end-of-file marker of the tar archive.
  */
 void fuzz_end_of_file()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
     printf("\n+++ Fuzzing End of File +++\n");
     int prev_success = test_status.number_of_success;
 
@@ -524,16 +812,17 @@ void fuzz_end_of_file()
     char content[] = "End of file test data.";
     size_t content_size = sizeof(content);
     char end_data[END_BYTES * 4] = {0};
+    char size_field[12];
+    num_encode(size_field, sizeof(size_field), content_size, NUM_OCTAL_MINIMAL);
 
     for (size_t i = 0; i < sizeof(end_sizes) / sizeof(end_sizes[0]); i++)
     { // Changed to size_t
-        tar_init_header(&header);
-        tar_generate(&header, NULL, 0, end_data, end_sizes[i]);
+        tar_case_init(&tc, header_template);
+        tar_generate_case(&tc, NULL, 0, end_data, end_sizes[i]);
         run_extractor(extractor_path);
 
-        tar_init_header(&header);
-        snprintf(header.size, sizeof(header.size), "%o", (unsigned int)content_size);
-        tar_generate(&header, content, content_size, end_data, end_sizes[i]);
+        TAR_CASE_PATCH(&tc, size, size_field, sizeof(size_field));
+        tar_generate_case(&tc, content, content_size, end_data, end_sizes[i]);
         run_extractor(extractor_path);
     }
     test_status.end_of_file_fuzzing_success = test_status.number_of_success - prev_success;
@@ -545,42 +834,43 @@ void fuzz_end_of_file()
  */
 void fuzz_known_crashes()
 {
-    tar_header header;
-    tar_init_header(&header);
+    struct tar_case tc;
+    tar_case_init(&tc, header_template);
     printf("\n+++ Fuzzing Known Crash Conditions +++\n");
     int prev_success = test_status.number_of_success;
 
-    memset(header.name, '\xFF', sizeof(header.name));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, name, '\xFF');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.name_fuzzing_success++;
 
-    header.typeflag = '\x90';
-    tar_generate_empty(&header);
+    tar_case_set_byte(&tc, offsetof(tar_header, typeflag), '\x90');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.typeflag_fuzzing_success++;
 
     char content[] = "Negative size test.";
-    snprintf(header.size, sizeof(header.size), "-000000001"); // 10 bytes + null
-    tar_generate(&header, content, sizeof(content), NULL, 0);
+    CASE_PRINT(&tc, size, "-000000001"); // 10 bytes + null
+    tar_generate_case(&tc, content, sizeof(content), NULL, 0);
     if (run_extractor(extractor_path))
         test_status.size_fuzzing_success++;
 
-    snprintf(header.mtime, sizeof(header.mtime), "77777777777");
-    tar_generate_empty(&header);
+    CASE_PRINT(&tc, mtime, "77777777777");
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.mtime_fuzzing_success++;
 
     update_checksum = 0;
-    tar_init_header(&header);
-    snprintf(header.chksum, sizeof(header.chksum), "9999999"); // 7 bytes + null
-    tar_generate_empty(&header);
+    tar_case_init(&tc, header_template);
+    CASE_FILL(&tc, chksum, '\0');
+    CASE_PRINT(&tc, chksum, "9999999"); // 7 bytes + null
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.checksum_fuzzing_success++;
     update_checksum = 1;
 
-    memset(header.uid, '9', sizeof(header.uid));
-    tar_generate_empty(&header);
+    CASE_FILL(&tc, uid, '9');
+    tar_generate_case_empty(&tc);
     if (run_extractor(extractor_path))
         test_status.uid_fuzzing_success++;
 
@@ -602,7 +892,7 @@ void fuzz_multi_file()
     snprintf(h2.size, sizeof(h2.size), "99999999999");
     memset(h2.name, '\xFF', sizeof(h2.name));
     char content[] = "Multi-file content";
-    FILE *fp = fopen("archive.tar", "wb");
+    FILE *fp = tar_archive_open();
     fwrite(&h1, sizeof(tar_header), 1, fp);
     fwrite(&h2, sizeof(tar_header), 1, fp);
     fwrite(content, sizeof(content), 1, fp);
@@ -618,8 +908,8 @@ void fuzz_multi_file()
     h2.typeflag = '\x91';
     char huge_content[1024 * 1024];
     memset(huge_content, 'X', sizeof(huge_content));
-    snprintf(h2.size, sizeof(h2.size), "%lo", (unsigned long)sizeof(huge_content));
-    fp = fopen("archive.tar", "wb");
+    num_encode(h2.size, sizeof(h2.size), sizeof(huge_content), NUM_OCTAL_MINIMAL);
+    fp = tar_archive_open();
     fwrite(&h1, sizeof(tar_header), 1, fp);
     fwrite(&h2, sizeof(tar_header), 1, fp);
     fwrite(huge_content, sizeof(huge_content), 1, fp);
@@ -634,7 +924,7 @@ void fuzz_multi_file()
     update_checksum = 0;
     snprintf(h2.chksum, sizeof(h2.chksum), "9999999"); // 7 bytes + null
     memset(h2.prefix, '\xFF', sizeof(h2.prefix));
-    fp = fopen("archive.tar", "wb");
+    fp = tar_archive_open();
     fwrite(&h1, sizeof(tar_header), 1, fp);
     fwrite(&h2, sizeof(tar_header), 1, fp);
     fwrite(content, sizeof(content), 1, fp);
@@ -659,8 +949,11 @@ void fuzz_overflow_all()
     memcpy(header.version, "00", sizeof(header.version)); // Fixed
     char content[1024 * 1024];
     memset(content, '\xFF', sizeof(content));
-    snprintf(header.size, sizeof(header.size), "%lo", (unsigned long)sizeof(content));
-    FILE *fp = fopen("archive.tar", "wb");
+    // Minimal digits and their NUL only, as "%lo" wrote them: the 0xFF tail is part of the case
+    char size_field[12];
+    num_encode(size_field, sizeof(size_field), sizeof(content), NUM_OCTAL_MINIMAL);
+    memcpy(header.size, size_field, strlen(size_field) + 1);
+    FILE *fp = tar_archive_open();
     fwrite(&header, sizeof(tar_header), 1, fp);
     fwrite(content, sizeof(content), 1, fp);
     char end[END_BYTES] = {0};
@@ -672,18 +965,417 @@ void fuzz_overflow_all()
     printf("+++ Overflow All Fuzzing Done +++\n");
 }
 
+/**
+ * @brief Replay every seed entry as a one-entry archive, unmodified and then
+ * with a few header mutations.
+ *
+ * The unmodified replay is the seed header byte for byte, its checksum
+ * field included. The first SEED_CONTENT_LIMIT bytes of the payload are
+ * written straight from the mapping and the rest of it, padding and end
+ * marker are a hole, so the size field always matches the archive and a
+ * multi-gigabyte member costs no more than a small one.
+ */
+void fuzz_seeds()
+{
+    printf("\n+++ Fuzzing Seeds +++\n");
+    struct tar_mutator m;
+    tar_mutator_init(&m, (unsigned long long)time(NULL));
+    m.dictionary = &dictionary;
+    struct tar_case tc;
+
+    for (size_t i = 0; i < seeds.entry_count; i++)
+    {
+        struct corpus_entry *e = &seeds.entries[i];
+        unsigned long long padding = (BLOCK_SIZE - e->payload_size % BLOCK_SIZE) % BLOCK_SIZE;
+        size_t content = e->payload_size < SEED_CONTENT_LIMIT ? (size_t)e->payload_size : SEED_CONTENT_LIMIT;
+        unsigned long long zeros = e->payload_size - content + padding + END_BYTES;
+        for (int run = 0; run <= SEED_MUTATIONS; run++)
+        {
+            if (run == 0)
+            {
+                tar_generate_verbatim(e->header, e->payload, content, zeros);
+            }
+            else
+            {
+                tar_case_load(&tc, e->header);
+                tar_mutate_header(&m, &tc);
+                tar_generate_segments(&tc, e->payload, content, content, zeros);
+            }
+            if (run_extractor(extractor_path))
+                test_status.seed_fuzzing_success++;
+        }
+    }
+    printf("+++ Seed Fuzzing Done +++\n");
+}
+
+/**
+ * @brief Pick a crossover parent among the seed archives and the crash files.
+ * @param is_crash Set to 1 if the parent is a crash file.
+ */
+static const struct corpus_archive *crossover_parent(struct tar_mutator *m, struct corpus *crashes, int *is_crash)
+{
+    size_t pick = tar_mutator_below(m, seeds.archive_count + crashes->archive_count);
+    *is_crash = pick >= seeds.archive_count;
+    if (pick < seeds.archive_count)
+        return &seeds.archives[pick];
+    return &crashes->archives[pick - seeds.archive_count];
+}
+
+/**
+ * @brief Pick one header of @p p, found by following its size fields.
+ * @param payload Set to what follows the header in the mapping.
+ * @param available Set to the bytes left after the header.
+ */
+static const tar_header *crossover_header(struct tar_mutator *m, const struct corpus_archive *p,
+                                          const char **payload, size_t *available)
+{
+    size_t offsets[CROSSOVER_ENTRIES];
+    size_t count = tar_archive_headers(p->map, p->length, offsets, CROSSOVER_ENTRIES);
+    size_t offset = count > 0 ? offsets[tar_mutator_below(m, count)] : 0;
+    *payload = p->map + offset + HEADER_LENGTH;
+    *available = p->length - offset - HEADER_LENGTH;
+    return (const tar_header *)(p->map + offset);
+}
+
+/**
+ * @brief Append one child of two parents to @p arena.
+ *
+ * Even runs splice whole entries, odd runs combine two headers of the
+ * parents field by field and keep the payload matching the chosen size
+ * field. Either way at most CROSSOVER_PAYLOAD_LIMIT bytes of a payload are
+ * copied, so multi-megabyte seeds breed as cheaply as small ones.
+ */
+static int crossover_child(struct tar_mutator *m, struct tar_archive *arena, const struct corpus_archive *a,
+                           const struct corpus_archive *b, int run)
+{
+    if (run % 2 == 0)
+        return tar_crossover_archive(m, arena, a->map, a->length, b->map, b->length, CROSSOVER_PAYLOAD_LIMIT);
+
+    const char *a_payload, *b_payload;
+    size_t a_available, b_available;
+    const tar_header *a_header = crossover_header(m, a, &a_payload, &a_available);
+    const tar_header *b_header = crossover_header(m, b, &b_payload, &b_available);
+    struct tar_case tc;
+    int size_from_b;
+    tar_crossover_header(m, &tc, a_header, b_header, &size_from_b);
+    unsigned long long declared = num_decode(tc.header.size, sizeof(tc.header.size));
+    size_t available = size_from_b ? b_available : a_available;
+    size_t payload_size = declared < available ? (size_t)declared : available;
+    payload_size = payload_size < CROSSOVER_PAYLOAD_LIMIT ? payload_size : CROSSOVER_PAYLOAD_LIMIT;
+    if (tar_archive_add_entry(arena, &tc.header, size_from_b ? b_payload : a_payload, payload_size) == -1)
+        return -1;
+    return tar_archive_add_end(arena, END_BYTES);
+}
+
+/**
+ * @brief Breed new cases from the interesting inputs found so far.
+ *
+ * The pool is every seed archive plus every crash file saved by the earlier
+ * stages, mapped rather than read. Children are built CROSSOVER_BATCH at a
+ * time back to back in one arena, copied once from the mappings, then
+ * written out one by one. A child of two crash files that crashes is
+ * expected rather than found, so it is not counted.
+ */
+void fuzz_crossover()
+{
+    printf("\n+++ Fuzzing Crossover +++\n");
+    struct corpus crashes;
+    corpus_init(&crashes);
+    char name[32];
+    for (int i = 1; i <= test_status.number_of_success; i++)
+    {
+        snprintf(name, sizeof(name), "success_%d.tar", i);
+        corpus_add_file(&crashes, name);
+    }
+    if (seeds.archive_count + crashes.archive_count < 2)
+    {
+        printf("Not enough seeds or crash files to cross over\n");
+        corpus_free(&crashes);
+        printf("+++ Crossover Fuzzing Done +++\n");
+        return;
+    }
+
+    struct tar_mutator m;
+    tar_mutator_init(&m, (unsigned long long)time(NULL));
+    struct tar_archive arena;
+    if (tar_archive_init(&arena, CROSSOVER_BATCH * 64 * BLOCK_SIZE) == -1)
+    {
+        corpus_free(&crashes);
+        return;
+    }
+    size_t offsets[CROSSOVER_BATCH + 1];
+    int counted[CROSSOVER_BATCH];
+
+    for (int run = 0; run < CROSSOVER_RUNS; run += CROSSOVER_BATCH)
+    {
+        tar_archive_reset(&arena);
+        size_t count = 0;
+        for (int i = run; i < run + CROSSOVER_BATCH && i < CROSSOVER_RUNS; i++)
+        {
+            int a_crash, b_crash;
+            const struct corpus_archive *a = crossover_parent(&m, &crashes, &a_crash);
+            const struct corpus_archive *b = crossover_parent(&m, &crashes, &b_crash);
+            size_t length = arena.length;
+            if (crossover_child(&m, &arena, a, b, i) == -1)
+            {
+                arena.length = length;
+                continue;
+            }
+            offsets[count] = length;
+            counted[count] = !(a_crash && b_crash);
+            count++;
+        }
+        offsets[count] = arena.length;
+        for (size_t i = 0; i < count; i++)
+        {
+            tar_generate_raw(arena.data + offsets[i], offsets[i + 1] - offsets[i]);
+            if (run_extractor(extractor_path) && counted[i])
+                test_status.crossover_fuzzing_success++;
+        }
+    }
+    tar_archive_free(&arena);
+    corpus_free(&crashes);
+    printf("+++ Crossover Fuzzing Done +++\n");
+}
+
+/**
+ * @brief Run mutated archives through the generator/executor pipeline
+ * instead of the fuzz suite.
+ */
+void fuzz_pipeline(struct pipeline_config *config)
+{
+    printf("\n+++ Fuzzing Pipeline +++\n");
+    struct pipeline_stats stats;
+    config->extractor = extractor_path;
+    config->seeds = &seeds;
+    config->dictionary = &dictionary;
+    config->seed = (unsigned long long)time(NULL);
+    if (pipeline_run(config, &stats) == -1)
+    {
+        printf("Unable to start the pipeline\n");
+        return;
+    }
+    test_status.pipeline_fuzzing_success += stats.crashes;
+    pipeline_print_stats(config, &stats);
+    printf("+++ Pipeline Fuzzing Done +++\n");
+}
+
+/**
+ * @brief Stream one giant archive into the extractor instead of the fuzz suite.
+ */
+void fuzz_stream(struct stream_plan *plan)
+{
+    printf("\n+++ Streaming Giant Archive +++\n");
+    int rv = stream_run(extractor_path, plan);
+    if (rv == 1)
+        test_status.stream_fuzzing_success++;
+    else if (rv == -1)
+        printf("Stream run failed\n");
+    printf("+++ Stream Fuzzing Done +++\n");
+}
+
+static void usage(const char *program)
+{
+    printf("Usage: %s <extractor_path> [options]\n", program);
+    printf("  --template <kind>          base header: regular, symlink or dir\n");
+    printf("  --seeds <dir>              replay and mutate the entries of every .tar in dir\n");
+    printf("  --snapshot                 run the extractor from a ptrace snapshot instead of a new process\n");
+    printf("  --diff \"<command>\"       also run every archive through a reference extractor\n");
+    printf("  --covering <t>             also run a t-way covering array (t = 2 or 3) over all fields\n");
+    printf("  --no-dictionary            do not take tokens from the extractor binary\n");
+    printf("  --sweep <bytes>            also sweep size, payload, padding and end marker up to bytes\n");
+    printf("  --pipeline <archives>      run mutated archives on parallel executor threads instead\n");
+    printf("  --workers <n>              pipeline executor threads (default: one per CPU)\n");
+    printf("  --adaptive                 let the pipeline find the fastest executor count, up to --workers\n");
+    printf("  --pin                      pin each pipeline executor and its extractors to one CPU\n");
+    printf("  --stream <entries>         stream one giant archive through stdin instead (GNU tar: -B)\n");
+    printf("  --stream-size <bytes>      payload bytes of every streamed entry (default 0)\n");
+    printf("  --stream-mutate <i,j,...>  streamed entry indices whose headers get corrupted\n");
+}
+
 /**
  * @brief Main entry point for the fuzzer.
  */
 int main(int argc, char *argv[])
 {
-    if (argc != 2)
+    if (argc < 2)
     {
-        printf("Usage: %s <extractor_path>\n", argv[0]);
+        usage(argv[0]);
         return 1;
     }
     extractor_path = argv[1];
+    struct stream_plan stream_plan;
+    memset(&stream_plan, 0, sizeof(stream_plan));
+    const char *seeds_dir = NULL;
+    int covering_strength = 0;
+    int use_snapshot = 0;
+    int use_diff = 0;
+    int use_dictionary = 1;
+    unsigned long long sweep_limit = 0;
+    struct pipeline_config pipeline_config;
+    memset(&pipeline_config, 0, sizeof(pipeline_config));
+    pipeline_config.executors = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers_given = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--diff") == 0 && i + 1 < argc)
+        {
+            if (differential_add_target(argv[++i]) == -1)
+                return 1;
+            use_diff = 1;
+        }
+        else if (strcmp(argv[i], "--template") == 0 && i + 1 < argc)
+        {
+            int kind = tar_template_parse(argv[++i]);
+            if (kind == -1)
+            {
+                printf("Unknown template: %s\n", argv[i]);
+                return 1;
+            }
+            // The stages write one header and no payload: a pax header would
+            // never get its records nor the entry they describe
+            if (kind == TEMPLATE_PAX)
+            {
+                printf("The pax template is only used by the library mutators\n");
+                return 1;
+            }
+            header_template = kind;
+        }
+        else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc)
+        {
+            seeds_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--covering") == 0 && i + 1 < argc)
+        {
+            covering_strength = atoi(argv[++i]);
+            if (covering_strength != 2 && covering_strength != 3)
+            {
+                printf("Covering strength must be 2 or 3\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--snapshot") == 0)
+        {
+            use_snapshot = 1;
+        }
+        else if (strcmp(argv[i], "--no-dictionary") == 0)
+        {
+            use_dictionary = 0;
+        }
+        else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc)
+        {
+            sweep_limit = strtoull(argv[++i], NULL, 10);
+            if (sweep_limit == 0 || sweep_limit > num_field_max(12, NUM_OCTAL_NUL))
+            {
+                printf("Sweep limit must be between 1 and %llu bytes\n", num_field_max(12, NUM_OCTAL_NUL));
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc)
+        {
+            pipeline_config.archives = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            pipeline_config.executors = atoi(argv[++i]);
+            workers_given = 1;
+        }
+        else if (strcmp(argv[i], "--adaptive") == 0)
+        {
+            pipeline_config.adaptive = 1;
+        }
+        else if (strcmp(argv[i], "--pin") == 0)
+        {
+            pipeline_config.pin = 1;
+        }
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc)
+        {
+            stream_plan.entries = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--stream-size") == 0 && i + 1 < argc)
+        {
+            stream_plan.entry_size = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--stream-mutate") == 0 && i + 1 < argc)
+        {
+            if (stream_parse_mutations(&stream_plan, argv[++i]) == -1)
+                return 1;
+        }
+        else
+        {
+            printf("Unknown option: %s\n", argv[i]);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // Both modes run the target themselves, with no sandbox or snapshot
+    if ((stream_plan.entries > 0 || pipeline_config.archives > 0) && (use_diff || use_snapshot))
+    {
+        printf("--stream and --pipeline cannot be combined with --diff or --snapshot\n");
+        return 1;
+    }
     init_test_status(&test_status);
+    tar_templates_init();
+    corpus_init(&seeds);
+    if (seeds_dir)
+    {
+        struct timespec start, stop;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int archives = corpus_load_dir(&seeds, seeds_dir);
+        clock_gettime(CLOCK_MONOTONIC, &stop);
+        if (archives == -1)
+        {
+            printf("Unable to read seed directory %s\n", seeds_dir);
+            return 1;
+        }
+        printf("Loaded %zu seed entries from %d archives in %.3fs (%lu cut short by a bad header)\n",
+               seeds.entry_count, archives,
+               (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9, seeds.invalid_headers);
+    }
+    tar_dictionary_init(&dictionary);
+    if (use_dictionary)
+    {
+        if (tar_dictionary_load_elf(&dictionary, extractor_path) == -1)
+            printf("No dictionary: %s is not an ELF64 file\n", extractor_path);
+        else
+            printf("Dictionary: %zu tokens and %zu values from %s\n", dictionary.token_count,
+                   dictionary.value_count, extractor_path);
+    }
+
+    if (stream_plan.entries > 0)
+    {
+        fuzz_stream(&stream_plan);
+        print_test_status(&test_status);
+        return 0;
+    }
+    if (pipeline_config.archives > 0)
+    {
+        // Room for the controller to find out that oversubscribing does not pay
+        if (pipeline_config.adaptive && !workers_given)
+            pipeline_config.executors *= 2;
+        if (pipeline_config.executors > PIPELINE_MAX_THREADS * 8 / 9)
+            pipeline_config.executors = PIPELINE_MAX_THREADS * 8 / 9;
+        // One generator keeps up with about eight extractor processes
+        if (pipeline_config.executors < 1)
+            pipeline_config.executors = 1;
+        pipeline_config.generators = (pipeline_config.executors + 7) / 8;
+        fuzz_pipeline(&pipeline_config);
+        print_test_status(&test_status);
+        corpus_free(&seeds);
+        return 0;
+    }
+    if (differential_init(extractor_path) == -1)
+        return 1;
+    if (use_snapshot)
+    {
+        if (differential_enabled())
+        {
+            printf("--snapshot and --diff cannot be combined\n");
+            return 1;
+        }
+        if (snapshot_init(extractor_path) == -1)
+            return 1;
+    }
 
     printf("\n+++ Starting Fuzzing +++\n");
     fuzz_name();
@@ -699,16 +1391,27 @@ int main(int argc, char *argv[])
     fuzz_version();
     fuzz_uname();
     fuzz_gname();
+    fuzz_numeric();
     fuzz_end_of_file();
+    if (sweep_limit)
+        fuzz_sweep(sweep_limit);
     fuzz_known_crashes();
     fuzz_multi_file();
     fuzz_huge_content();
     fuzz_prefix();
     fuzz_padding_footer();
     fuzz_combo();
+    if (covering_strength)
+        fuzz_covering(covering_strength);
+    fuzz_dictionary();
     fuzz_overflow_all();
+    fuzz_seeds();
+    fuzz_crossover();
     printf("+++ Fuzzing Completed +++\n");
 
     print_test_status(&test_status);
+    differential_cleanup();
+    snapshot_cleanup();
+    corpus_free(&seeds);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include <string.h>
+#include "numfield.h"
+#include "archive.h"
+#include "mutate.h"
+
+#define MAX_ARCHIVE_HEADERS 64
+#define MAX_STACKED_MUTATIONS 3
+
+const struct text_field text_fields[TEXT_FIELD_COUNT] = {
+    {"name", offsetof(tar_header, name), sizeof(((tar_header *)0)->name)},
+    {"linkname", offsetof(tar_header, linkname), sizeof(((tar_header *)0)->linkname)},
+    {"magic", offsetof(tar_header, magic), sizeof(((tar_header *)0)->magic)},
+    {"version", offsetof(tar_header, version), sizeof(((tar_header *)0)->version)},
+    {"uname", offsetof(tar_header, uname), sizeof(((tar_header *)0)->uname)},
+    {"gname", offsetof(tar_header, gname), sizeof(((tar_header *)0)->gname)},
+    {"prefix", offsetof(tar_header, prefix), sizeof(((tar_header *)0)->prefix)},
+    {"padding", offsetof(tar_header, padding), sizeof(((tar_header *)0)->padding)},
+};
+
+static const char typeflags[] = {REGTYPE, AREGTYPE, LNKTYPE, SYMTYPE, CHRTYPE, BLKTYPE, DIRTYPE,
+                                 FIFOTYPE, CONTTYPE, XHDTYPE, XGLTYPE, 'L', 'K', 'S', '\x90', '\xFF'};
+
+void tar_mutator_init(struct tar_mutator *m, unsigned long long seed)
+{
+    m->rng = seed * 0x9E3779B97F4A7C15ULL + 1; // never 0, which xorshift cannot leave
+    m->dictionary = NULL;
+}
+
+/**
+ * @brief xorshift64* step.
+ */
+unsigned long long tar_mutator_next(struct tar_mutator *m)
+{
+    m->rng ^= m->rng >> 12;
+    m->rng ^= m->rng << 25;
+    m->rng ^= m->rng >> 27;
+    return m->rng * 0x2545F4914F6CDD1DULL;
+}
+
+unsigned long long tar_mutator_below(struct tar_mutator *m, unsigned long long bound)
+{
+    return bound ? tar_mutator_next(m) % bound : 0;
+}
+
+/**
+ * @brief Rewrite a numeric field with a random encoding of an edge, small,
+ * random or negative value.
+ */
+void tar_mutate_numeric(struct tar_mutator *m, struct tar_case *c, int field)
+{
+    const struct num_field *f = &num_fields[field];
+    char buf[12];
+    enum num_format fmt = tar_mutator_below(m, NUM_FORMAT_COUNT);
+    unsigned long long edges[3];
+    unsigned long long value;
+    int choice = tar_mutator_below(m, 6);
+    if (choice < 3)
+    {
+        num_edge_values(f->width, fmt, edges);
+        value = edges[choice];
+    }
+    else if (choice == 3)
+        value = tar_mutator_below(m, 2 * BLOCK_SIZE);
+    else if (choice == 4)
+        value = tar_mutator_next(m) >> tar_mutator_below(m, 64);
+    else
+        value = ~0ULL; // -1, base-256 negative
+    num_encode(buf, f->width, value, fmt);
+    tar_case_patch(c, f->offset, buf, f->width);
+}
+
+/**
+ * @brief Rewrite a text field: overflow, missing or misplaced NUL, path
+ * traversal, emptiness or a single flipped byte.
+ */
+void tar_mutate_text(struct tar_mutator *m, struct tar_case *c, int field)
+{
+    const struct text_field *f = &text_fields[field];
+    char buf[155];
+    size_t width = f->width;
+    memcpy(buf, (char *)&c->header + f->offset, width);
+    switch (tar_mutator_below(m, 6))
+    {
+    case 0:
+        memset(buf, '\xFF', width);
+        break;
+    case 1:
+        memset(buf, 'A' + tar_mutator_below(m, 26), width);
+        break;
+    case 2:
+        for (size_t i = 0; i < width; i++)
+            buf[i] = (char)tar_mutator_next(m);
+        buf[tar_mutator_below(m, width)] = '\0';
+        break;
+    case 3:
+        memset(buf, 0, width);
+        break;
+    case 4:
+    {
+        static const char traversal[] = "../../../../../../tmp/fuzz-tar";
+        size_t len = sizeof(traversal) < width ? sizeof(traversal) : width;
+        memset(buf, 0, width);
+        memcpy(buf, traversal, len);
+        break;
+    }
+    default:
+        buf[tar_mutator_below(m, width)] ^= (char)(1 << tar_mutator_below(m, 8));
+        break;
+    }
+    tar_case_patch(c, f->offset, buf, width);
+}
+
+void tar_mutate_typeflag(struct tar_mutator *m, struct tar_case *c)
+{
+    char flag = tar_mutator_below(m, 4) == 0 ? (char)tar_mutator_next(m)
+                                              : typeflags[tar_mutator_below(m, sizeof(typeflags))];
+    tar_case_set_byte(c, offsetof(tar_header, typeflag), flag);
+}
+
+/**
+ * @brief Corrupt the stored checksum; call after tar_case_finalize().
+ */
+void tar_mutate_checksum(struct tar_mutator *m, struct tar_case *c)
+{
+    char *chksum = c->header.chksum;
+    switch (tar_mutator_below(m, 3))
+    {
+    case 0:
+        chksum[tar_mutator_below(m, 6)] ^= 1; // off by a little
+        break;
+    case 1:
+        num_encode(chksum, CHKSUM_LENGTH, tar_mutator_next(m), tar_mutator_below(m, NUM_FORMAT_COUNT));
+        break;
+    default:
+        memset(chksum, ' ', CHKSUM_LENGTH);
+        break;
+    }
+}
+
+/**
+ * @brief Write a dictionary entry into a random field: a token at the start
+ * of the field (sometimes further in), NUL-terminated half of the time when
+ * it leaves room, or a value or its neighbour encoded into a numeric field.
+ * Does nothing without a dictionary.
+ */
+void tar_mutate_token(struct tar_mutator *m, struct tar_case *c)
+{
+    const struct tar_dictionary *d = m->dictionary;
+    if (!d || d->token_count + d->value_count == 0)
+        return;
+    size_t pick = tar_mutator_below(m, d->token_count + d->value_count);
+    char buf[155];
+    if (pick >= d->token_count)
+    {
+        const struct num_field *f = &num_fields[tar_mutator_below(m, NUM_FIELD_COUNT)];
+        unsigned long long value = d->values[pick - d->token_count] + tar_mutator_below(m, 3) - 1;
+        num_encode(buf, f->width, value, tar_mutator_below(m, NUM_FORMAT_COUNT));
+        tar_case_patch(c, f->offset, buf, f->width);
+        return;
+    }
+
+    const struct tar_token *t = &d->tokens[pick];
+    size_t offset = offsetof(tar_header, typeflag), width = 1;
+    int field = tar_mutator_below(m, NUM_FIELD_COUNT + TEXT_FIELD_COUNT + 1);
+    if (field < NUM_FIELD_COUNT)
+    {
+        offset = num_fields[field].offset;
+        width = num_fields[field].width;
+    }
+    else if (field < NUM_FIELD_COUNT + TEXT_FIELD_COUNT)
+    {
+        offset = text_fields[field - NUM_FIELD_COUNT].offset;
+        width = text_fields[field - NUM_FIELD_COUNT].width;
+    }
+    size_t length = t->length < width ? t->length : width;
+    size_t at = tar_mutator_below(m, 4) == 0 ? tar_mutator_below(m, width - length + 1) : 0;
+    memcpy(buf, (char *)&c->header + offset, width);
+    memcpy(buf + at, t->bytes, length);
+    if (at + length < width && tar_mutator_below(m, 2))
+        buf[at + length] = '\0';
+    tar_case_patch(c, offset, buf, width);
+}
+
+/**
+ * @brief Apply one to three random field mutations and fix up the checksum,
+ * unless the checksum itself was picked. With a dictionary, inserting one of
+ * its entries is one more mutation to pick from.
+ */
+void tar_mutate_header(struct tar_mutator *m, struct tar_case *c)
+{
+    int corrupt_checksum = 0;
+    int dictionary = m->dictionary && m->dictionary->token_count + m->dictionary->value_count > 0;
+    int count = 1 + tar_mutator_below(m, MAX_STACKED_MUTATIONS);
+    for (int i = 0; i < count; i++)
+    {
+        int pick = tar_mutator_below(m, NUM_FIELD_COUNT + TEXT_FIELD_COUNT + 1 + dictionary);
+        if (pick < NUM_FIELD_COUNT)
+        {
+            if (num_fields[pick].offset == CHKSUM_OFFSET)
+                corrupt_checksum = 1;
+            else
+                tar_mutate_numeric(m, c, pick);
+        }
+        else if (pick < NUM_FIELD_COUNT + TEXT_FIELD_COUNT)
+        {
+            tar_mutate_text(m, c, pick - NUM_FIELD_COUNT);
+        }
+        else if (pick == NUM_FIELD_COUNT + TEXT_FIELD_COUNT)
+        {
+            tar_mutate_typeflag(m, c);
+        }
+        else
+        {
+            tar_mutate_token(m, c);
+        }
+    }
+    tar_case_finalize(c);
+    if (corrupt_checksum)
+        tar_mutate_checksum(m, c);
+}
+
+/**
+ * @brief Write a mutated template entry plus end marker at @p offset.
+ * @return New archive length, or 0 if it does not fit in @p max_size.
+ */
+static size_t write_fresh_entry(struct tar_mutator *m, unsigned char *data, size_t offset, size_t max_size)
+{
+    struct tar_case c;
+    struct tar_archive a;
+    size_t payload_size;
+    enum tar_template_kind kind = tar_mutator_below(m, TEMPLATE_COUNT);
+    const char *payload = tar_template_payload(kind, &payload_size);
+    tar_case_init(&c, kind);
+    tar_mutate_header(m, &c);
+    tar_archive_wrap(&a, data, offset, max_size);
+    if (tar_archive_add_entry(&a, &c.header, payload, payload_size) == -1)
+        return 0;
+    tar_archive_add_end(&a, END_BYTES); // best effort, a missing end marker is a test case too
+    return a.length;
+}
+
+/**
+ * @brief Mutate a whole archive in place.
+ *
+ * Most of the time one header found by following the size fields is mutated;
+ * sometimes a new entry is appended after the last one. Inputs without a
+ * usable header are replaced by a fresh entry built from a template.
+ *
+ * @return The new size, never more than @p max_size.
+ */
+size_t tar_mutate_archive(struct tar_mutator *m, unsigned char *data, size_t size, size_t max_size)
+{
+    size_t offsets[MAX_ARCHIVE_HEADERS];
+    size_t count = tar_archive_headers((const char *)data, size, offsets, MAX_ARCHIVE_HEADERS);
+    if (count == 0)
+    {
+        size_t length = write_fresh_entry(m, data, 0, max_size);
+        return length ? length : size;
+    }
+
+    if (tar_mutator_below(m, 8) == 0)
+    {
+        const tar_header *last = (const tar_header *)(data + offsets[count - 1]);
+        unsigned long long last_size = num_decode(last->size, sizeof(last->size));
+        // Clamped before rounding, as in crossover: a base-256 size near 2^64 would wrap end
+        if (last_size > size - offsets[count - 1] - HEADER_LENGTH)
+            last_size = size - offsets[count - 1] - HEADER_LENGTH;
+        size_t end = offsets[count - 1] + HEADER_LENGTH + (last_size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+        size_t length = end <= size ? write_fresh_entry(m, data, end, max_size) : 0;
+        if (length)
+            return length;
+    }
+
+    struct tar_case c;
+    size_t offset = offsets[tar_mutator_below(m, count)];
+    tar_case_load(&c, (const tar_header *)(data + offset));
+    tar_mutate_header(m, &c);
+    memcpy(data + offset, &c.header, HEADER_LENGTH);
+    return size;
+}
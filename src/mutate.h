@@ -0,0 +1,38 @@
+#ifndef MUTATE_H
+#define MUTATE_H
+#include <stddef.h>
+#include "template.h"
+#include "dictionary.h"
+
+/* Mutation state. Everything a mutator needs is in here, so independent
+ * mutators can run in parallel. */
+struct tar_mutator
+{
+    unsigned long long rng;
+    const struct tar_dictionary *dictionary; /* optional, shared read-only */
+};
+
+/* Offset and width of every text field of tar_header */
+struct text_field
+{
+    const char *name;
+    size_t offset;
+    size_t width;
+};
+
+#define TEXT_FIELD_COUNT 8
+extern const struct text_field text_fields[TEXT_FIELD_COUNT];
+
+void tar_mutator_init(struct tar_mutator *m, unsigned long long seed);
+unsigned long long tar_mutator_next(struct tar_mutator *m);
+unsigned long long tar_mutator_below(struct tar_mutator *m, unsigned long long bound);
+
+void tar_mutate_numeric(struct tar_mutator *m, struct tar_case *c, int field);
+void tar_mutate_text(struct tar_mutator *m, struct tar_case *c, int field);
+void tar_mutate_typeflag(struct tar_mutator *m, struct tar_case *c);
+void tar_mutate_checksum(struct tar_mutator *m, struct tar_case *c);
+void tar_mutate_token(struct tar_mutator *m, struct tar_case *c);
+void tar_mutate_header(struct tar_mutator *m, struct tar_case *c);
+size_t tar_mutate_archive(struct tar_mutator *m, unsigned char *data, size_t size, size_t max_size);
+
+#endif
@@ -0,0 +1,161 @@
+#include <string.h>
+#include "constants.h"
+#include "numfield.h"
+
+const struct num_field num_fields[NUM_FIELD_COUNT] = {
+    {"mode", offsetof(tar_header, mode), sizeof(((tar_header *)0)->mode)},
+    {"uid", offsetof(tar_header, uid), sizeof(((tar_header *)0)->uid)},
+    {"gid", offsetof(tar_header, gid), sizeof(((tar_header *)0)->gid)},
+    {"size", offsetof(tar_header, size), sizeof(((tar_header *)0)->size)},
+    {"mtime", offsetof(tar_header, mtime), sizeof(((tar_header *)0)->mtime)},
+    {"chksum", offsetof(tar_header, chksum), sizeof(((tar_header *)0)->chksum)},
+    {"devmajor", offsetof(tar_header, devmajor), sizeof(((tar_header *)0)->devmajor)},
+    {"devminor", offsetof(tar_header, devminor), sizeof(((tar_header *)0)->devminor)},
+};
+
+static const char *format_names[NUM_FORMAT_COUNT] = {
+    "octal-nul", "octal-space", "octal-full", "octal-minimal", "leading-spaces", "embedded-nul", "base256"};
+
+/* Two octal digits per lookup: entry i is the digits of i (0..63) */
+static const char octal_pairs[129] =
+    "0001020304050607101112131415161720212223242526273031323334353637"
+    "4041424344454647505152535455565760616263646566677071727374757677";
+
+/**
+ * @brief Write the low @p digits octal digits of @p value at @p out.
+ */
+static void put_octal(char *out, size_t digits, unsigned long long value)
+{
+    char *p = out + digits;
+    while (p - out >= 2)
+    {
+        p -= 2;
+        memcpy(p, &octal_pairs[(value & 63) * 2], 2);
+        value >>= 6;
+    }
+    if (p > out)
+        *--p = '0' + (value & 7);
+}
+
+static size_t octal_length(unsigned long long value)
+{
+    if (value == 0)
+        return 1;
+    return (64 - __builtin_clzll(value) + 2) / 3;
+}
+
+/**
+ * @brief Width-1 digits plus terminator; a value too big for that spills its
+ * top digit over the terminator, so field max + 1 comes out as "10000000".
+ */
+static size_t terminated_digits(size_t width, unsigned long long value)
+{
+    size_t digits = width - 1;
+    return (digits * 3 < 64 && value >> (digits * 3)) ? width : digits;
+}
+
+/**
+ * @brief Encode @p value into a numeric header field of @p width bytes.
+ *
+ * Every byte of the field is written. Values that do not fit are truncated
+ * to their low digits (low bytes for base-256).
+ *
+ * @return The number of bytes written, i.e. @p width.
+ */
+size_t num_encode(char *field, size_t width, unsigned long long value, enum num_format fmt)
+{
+    size_t digits;
+    switch (fmt)
+    {
+    case NUM_OCTAL_NUL:
+    case NUM_OCTAL_SPACE:
+    case NUM_EMBEDDED_NUL:
+        digits = terminated_digits(width, value);
+        put_octal(field, digits, value);
+        if (digits < width)
+            field[digits] = fmt == NUM_OCTAL_SPACE ? ' ' : '\0';
+        if (fmt == NUM_EMBEDDED_NUL)
+            field[(width - 1) / 2] = '\0';
+        break;
+    case NUM_OCTAL_FULL:
+        put_octal(field, width, value);
+        break;
+    case NUM_OCTAL_MINIMAL:
+    case NUM_LEADING_SPACES:
+        digits = octal_length(value);
+        if (digits >= width)
+            return num_encode(field, width, value, NUM_OCTAL_NUL);
+        memset(field, fmt == NUM_LEADING_SPACES ? ' ' : '\0', width);
+        put_octal(fmt == NUM_LEADING_SPACES ? field + width - 1 - digits : field, digits, value);
+        field[fmt == NUM_LEADING_SPACES ? width - 1 : digits] = '\0';
+        break;
+    case NUM_BASE256:
+    {
+        long long v = (long long)value; // arithmetic shifts give the 0xFF fill for negatives
+        for (size_t i = width; i-- > 0;)
+        {
+            field[i] = (char)(v & 0xFF);
+            v >>= 8;
+        }
+        if ((long long)value >= 0)
+            field[0] |= (char)0x80;
+        break;
+    }
+    default:
+        break;
+    }
+    return width;
+}
+
+/**
+ * @brief Largest value a well-formed field of this format can hold
+ * (base-256 is capped at 2^62 - 1 for fields of 8 bytes or more).
+ */
+unsigned long long num_field_max(size_t width, enum num_format fmt)
+{
+    if (fmt == NUM_BASE256) // 0x80 marks base-256, 0x40 is the sign bit
+        return width >= 8 ? (~0ULL >> 2) : (1ULL << (8 * width - 2)) - 1;
+    size_t digits = fmt == NUM_OCTAL_FULL ? width : width - 1;
+    return digits * 3 >= 64 ? ~0ULL : (1ULL << (digits * 3)) - 1;
+}
+
+/**
+ * @brief Fill @p out with max - 1, max and max + 1 for the field.
+ * @return Number of values written (3).
+ */
+int num_edge_values(size_t width, enum num_format fmt, unsigned long long out[3])
+{
+    unsigned long long max = num_field_max(width, fmt);
+    out[0] = max - 1;
+    out[1] = max;
+    out[2] = max + 1;
+    return 3;
+}
+
+/**
+ * @brief Read a numeric field the lenient way extractors do: leading blanks,
+ * octal digits up to the first non-digit, or GNU base-256 if the high bit is set.
+ */
+unsigned long long num_decode(const char *field, size_t width)
+{
+    const unsigned char *p = (const unsigned char *)field;
+    unsigned long long value = 0;
+    if (width > 0 && (p[0] & 0x80))
+    {
+        value = p[0] & 0x3F;
+        for (size_t i = 1; i < width; i++)
+            value = (value << 8) | p[i];
+        return (p[0] & 0x40) ? ~0ULL : value; // negative sizes are never usable
+    }
+    size_t i = 0;
+    while (i < width && p[i] == ' ')
+        i++;
+    for (; i < width && p[i] >= '0' && p[i] <= '7'; i++)
+        value = (value << 3) | (p[i] - '0');
+    return value;
+}
+
+const char *num_format_name(enum num_format fmt)
+{
+    return fmt < NUM_FORMAT_COUNT ? format_names[fmt] : "unknown";
+}
@@ -0,0 +1,35 @@
+#ifndef NUMFIELD_H
+#define NUMFIELD_H
+#include <stddef.h>
+
+/* Ways a numeric header field can be written, well formed or not */
+enum num_format
+{
+    NUM_OCTAL_NUL,      /* zero-padded octal filling width - 1, NUL terminated */
+    NUM_OCTAL_SPACE,    /* zero-padded octal filling width - 1, space terminated */
+    NUM_OCTAL_FULL,     /* zero-padded octal filling the whole field, no terminator */
+    NUM_OCTAL_MINIMAL,  /* octal without padding, NUL terminated, rest zeroed */
+    NUM_LEADING_SPACES, /* octal right-aligned behind spaces, NUL terminated */
+    NUM_EMBEDDED_NUL,   /* NUM_OCTAL_NUL with a NUL in the middle of the digits */
+    NUM_BASE256,        /* GNU binary: big-endian, high bit set, 0xFF-filled if negative */
+    NUM_FORMAT_COUNT
+};
+
+/* Offset and width of every numeric field of tar_header */
+struct num_field
+{
+    const char *name;
+    size_t offset;
+    size_t width;
+};
+
+#define NUM_FIELD_COUNT 8
+extern const struct num_field num_fields[NUM_FIELD_COUNT];
+
+size_t num_encode(char *field, size_t width, unsigned long long value, enum num_format fmt);
+unsigned long long num_field_max(size_t width, enum num_format fmt);
+unsigned long long num_decode(const char *field, size_t width);
+int num_edge_values(size_t width, enum num_format fmt, unsigned long long out[3]);
+const char *num_format_name(enum num_format fmt);
+
+#endif
@@ -0,0 +1,619 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <sched.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "utils.h"
+#include "executor.h"
+#include "archive.h"
+#include "mutate.h"
+#include "numfield.h"
+#include "ring.h"
+#include "pipeline.h"
+
+#define PIPELINE_PAYLOAD_LIMIT (4 * BLOCK_SIZE) /* payload bytes written at most, whatever the size field says */
+#define BACKOFF_SPINS 16                        /* sched_yield() rounds before sleeping */
+#define BACKOFF_SLEEP_NS 50000
+#define PARK_SLEEP_NS 1000000  /* how often a parked executor checks whether it may run */
+#define CONTROL_MIN_ARCHIVES 8 /* fewer archives in an interval are too few to judge by */
+#define CONTROL_GAIN 0.05      /* throughput gain that pays for one more executor */
+#define CONTROL_CV_GROWTH 1.5  /* latency spread growth taken as the box thrashing */
+#define CONTROL_CV_FLOOR 0.05
+#define CONTROL_HOLD 8         /* samples to stay put once both neighbours lost */
+
+/* PIPELINE_BATCH archives back to back in one buffer */
+struct batch
+{
+    struct tar_archive arena;
+    size_t count;
+    size_t offsets[PIPELINE_BATCH + 1];
+};
+
+struct pipeline
+{
+    const struct pipeline_config *config;
+    struct batch *batches;
+    size_t batch_count;
+    struct ring free_batches;
+    struct ring ready_batches;
+    size_t claimed; /* archives handed out to generators */
+    int generators_running;
+    int executors_running;
+    int active_executors; /* executors with a higher index are parked */
+    double deadline;
+    size_t crash_number; /* last success_N.tar written */
+    double start;
+    char extractor[4096];
+    int cpus[CPU_SETSIZE]; /* the CPUs this process may run on, for pinning */
+    int cpu_count;
+};
+
+/* Per-thread state; counters are summed once the threads are joined */
+struct worker
+{
+    struct pipeline *p;
+    int index;
+    pthread_t thread;
+    double busy;
+    double waiting;
+    double parked;
+    double exited; /* when the thread left its loop; a parked executor leaves before the run ends */
+    size_t archives; /* this and the latency sums are read by the controller */
+    unsigned long long latency_us;
+    unsigned long long latency_us2;
+    size_t crashes;
+    double ready_sum;
+    size_t ready_samples;
+};
+
+/* Hill climbing on the number of running executors: double it while that
+ * pays, then try one more or one less around the best count seen */
+struct controller
+{
+    int active;
+    int best;
+    int direction;
+    int ramping;
+    int rejected; /* probes in a row that lost to best */
+    int hold;
+    double best_rate;
+    double best_cv; /* latency standard deviation over mean at best */
+    double at;      /* totals at the last decision */
+    size_t archives;
+    unsigned long long latency_us;
+    unsigned long long latency_us2;
+    double active_time; /* integral of active executors over time */
+};
+
+static char payload[PIPELINE_PAYLOAD_LIMIT];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void backoff(unsigned int *spins)
+{
+    if ((*spins)++ < BACKOFF_SPINS)
+    {
+        sched_yield();
+        return;
+    }
+    struct timespec ts = {0, BACKOFF_SLEEP_NS};
+    nanosleep(&ts, NULL);
+}
+
+/**
+ * @brief Reserve up to PIPELINE_BATCH archives for a generator.
+ * @return Number of archives to generate, 0 when the run is over.
+ */
+static size_t claim(struct pipeline *p)
+{
+    if (p->config->seconds > 0 && now() >= p->deadline)
+        return 0;
+    if (p->config->archives == 0)
+        return PIPELINE_BATCH;
+    size_t first = __atomic_fetch_add(&p->claimed, PIPELINE_BATCH, __ATOMIC_RELAXED);
+    if (first >= p->config->archives)
+        return 0;
+    size_t left = p->config->archives - first;
+    return left < PIPELINE_BATCH ? left : PIPELINE_BATCH;
+}
+
+/**
+ * @brief Append one mutated archive: a template or seed header with stacked
+ * field mutations, its payload capped at PIPELINE_PAYLOAD_LIMIT.
+ */
+static int generate_archive(struct pipeline *p, struct tar_mutator *m, struct tar_archive *arena)
+{
+    struct tar_case tc;
+    struct corpus *seeds = p->config->seeds;
+    if (seeds && seeds->entry_count > 0 && tar_mutator_below(m, 2))
+        tar_case_load(&tc, seeds->entries[tar_mutator_below(m, seeds->entry_count)].header);
+    else
+        tar_case_init(&tc, header_template);
+    tar_mutate_header(m, &tc);
+    unsigned long long declared = num_decode(tc.header.size, sizeof(tc.header.size));
+    size_t content_size = declared < PIPELINE_PAYLOAD_LIMIT ? (size_t)declared : PIPELINE_PAYLOAD_LIMIT;
+    if (tar_archive_add_entry(arena, &tc.header, payload, content_size) == -1)
+        return -1;
+    return tar_archive_add_end(arena, END_BYTES);
+}
+
+static void *generator_main(void *arg)
+{
+    struct worker *w = arg;
+    struct pipeline *p = w->p;
+    struct tar_mutator m;
+    tar_mutator_init(&m, p->config->seed + w->index);
+    m.dictionary = p->config->dictionary;
+    size_t want;
+    while ((want = claim(p)) > 0)
+    {
+        size_t index;
+        unsigned int spins = 0;
+        double start = now();
+        while (ring_pop(&p->free_batches, &index) == -1)
+            backoff(&spins);
+        double filled = now();
+        w->waiting += filled - start;
+
+        struct batch *b = &p->batches[index];
+        tar_archive_reset(&b->arena);
+        b->count = 0;
+        for (size_t i = 0; i < want; i++)
+        {
+            b->offsets[b->count] = b->arena.length;
+            if (generate_archive(p, &m, &b->arena) == -1)
+                break;
+            b->count++;
+        }
+        b->offsets[b->count] = b->arena.length;
+        ring_push(&p->ready_batches, index); // never full: it has a cell per batch
+        w->busy += now() - filled;
+        w->archives += b->count;
+    }
+    __atomic_sub_fetch(&p->generators_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void save_crash(struct pipeline *p, const char *data, size_t length)
+{
+    size_t number = __atomic_add_fetch(&p->crash_number, 1, __ATOMIC_RELAXED);
+    char name[32];
+    snprintf(name, sizeof(name), "success_%zu.tar", number);
+    int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return;
+    if (write(fd, data, length) == (ssize_t)length && !p->config->quiet)
+        printf("Saved crash file: %s\n", name);
+    close(fd);
+}
+
+/**
+ * @brief Run one archive through the extractor from this executor's memfd.
+ *
+ * The memfd becomes the child's stdin and the extractor opens it as
+ * /proc/self/fd/0, so it can seek, and every executor has its own sandbox.
+ */
+static int execute_archive(struct pipeline *p, int fd, const char *sandbox, const char *data, size_t length)
+{
+    if (ftruncate(fd, 0) == -1 || pwrite(fd, data, length, 0) != (ssize_t)length)
+        return 0;
+    char *argv[] = {p->extractor, "/proc/self/fd/0", NULL};
+    struct exec_result res;
+    memset(&res, 0, sizeof(res));
+    int out_fd;
+    pid_t pid = exec_spawn(argv, sandbox, fd, &out_fd);
+    if (pid == -1)
+        return 0;
+    while (exec_drain(out_fd, &res))
+        ;
+    close(out_fd);
+    exec_finish(pid, &res);
+    exec_clear_directory(sandbox);
+    if (res.crashed)
+        save_crash(p, data, length);
+    return res.crashed;
+}
+
+/**
+ * @brief Pin the calling thread to one of the CPUs the process may use.
+ *
+ * The extractor processes the thread forks inherit the mask, and memory it
+ * touches first afterwards is allocated on that CPU's NUMA node.
+ */
+static void pin_executor(const struct pipeline *p, int index)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(p->cpus[index % p->cpu_count], &set);
+    if (sched_setaffinity(0, sizeof(set), &set) == -1) // 0: this thread, not the process
+        perror("sched_setaffinity");
+}
+
+static void *executor_main(void *arg)
+{
+    struct worker *w = arg;
+    struct pipeline *p = w->p;
+    // Before the memfd exists, so the archive pages it writes are node-local
+    if (p->config->pin && p->cpu_count > 0)
+        pin_executor(p, w->index);
+    char sandbox[32];
+    snprintf(sandbox, sizeof(sandbox), "sandbox_pipe_%d", w->index);
+    if (mkdir(sandbox, 0755) == -1 && errno != EEXIST)
+        perror(sandbox);
+    int fd = memfd_create("archive.tar", MFD_CLOEXEC);
+    if (fd == -1)
+        perror("memfd_create");
+
+    unsigned int spins = 0;
+    double idle_since = p->start; // waiting for the first batch counts too
+    for (;;)
+    {
+        if (w->index >= __atomic_load_n(&p->active_executors, __ATOMIC_RELAXED))
+        {
+            // Parked by the controller; executor 0 never is and drains the ring
+            if (__atomic_load_n(&p->generators_running, __ATOMIC_ACQUIRE) == 0)
+                break;
+            double parked = now();
+            w->waiting += parked - idle_since;
+            struct timespec ts = {0, PARK_SLEEP_NS};
+            nanosleep(&ts, NULL);
+            idle_since = now();
+            w->parked += idle_since - parked;
+            continue;
+        }
+        size_t index;
+        if (ring_pop(&p->ready_batches, &index) == -1)
+        {
+            // Generators push before they leave, so an empty ring after the last one left stays empty
+            if (__atomic_load_n(&p->generators_running, __ATOMIC_ACQUIRE) > 0)
+            {
+                backoff(&spins);
+                continue;
+            }
+            if (ring_pop(&p->ready_batches, &index) == -1)
+                break;
+        }
+        double start = now();
+        w->waiting += start - idle_since;
+        w->ready_sum += ring_size(&p->ready_batches) + 1;
+        w->ready_samples++;
+        spins = 0;
+
+        struct batch *b = &p->batches[index];
+        for (size_t i = 0; i < b->count && fd != -1; i++)
+        {
+            size_t length = b->offsets[i + 1] - b->offsets[i];
+            double started = now();
+            w->crashes += execute_archive(p, fd, sandbox, b->arena.data + b->offsets[i], length);
+            unsigned long long us = (now() - started) * 1e6;
+            __atomic_add_fetch(&w->latency_us, us, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&w->latency_us2, us * us, __ATOMIC_RELAXED);
+            __atomic_add_fetch(&w->archives, 1, __ATOMIC_RELAXED);
+        }
+        ring_push(&p->free_batches, index);
+        idle_since = now();
+        w->busy += idle_since - start;
+    }
+    w->exited = now();
+    w->waiting += w->exited - idle_since;
+    if (fd != -1)
+        close(fd);
+    rmdir(sandbox);
+    __atomic_sub_fetch(&p->executors_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static int setup(struct pipeline *p, const struct pipeline_config *config)
+{
+    memset(p, 0, sizeof(struct pipeline));
+    p->config = config;
+    if (!realpath(config->extractor, p->extractor))
+    {
+        perror(config->extractor);
+        return -1;
+    }
+    // Enough batches that every executor has one in hand and one queued
+    p->batch_count = 2 * config->executors + config->generators;
+    p->batches = calloc(p->batch_count, sizeof(struct batch));
+    if (!p->batches || ring_init(&p->free_batches, p->batch_count) == -1 ||
+        ring_init(&p->ready_batches, p->batch_count) == -1)
+        return -1;
+    for (size_t i = 0; i < p->batch_count; i++)
+    {
+        size_t capacity = PIPELINE_BATCH * (HEADER_LENGTH + PIPELINE_PAYLOAD_LIMIT + END_BYTES);
+        if (tar_archive_init(&p->batches[i].arena, capacity) == -1)
+            return -1;
+        ring_push(&p->free_batches, i);
+    }
+    p->crash_number = test_status.number_of_success;
+    memset(payload, 'C', sizeof(payload));
+    if (config->pin)
+    {
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            {
+                if (CPU_ISSET(cpu, &set))
+                    p->cpus[p->cpu_count++] = cpu;
+            }
+        }
+    }
+    return 0;
+}
+
+static void teardown(struct pipeline *p)
+{
+    for (size_t i = 0; p->batches && i < p->batch_count; i++)
+        tar_archive_free(&p->batches[i].arena);
+    free(p->batches);
+    ring_free(&p->free_batches);
+    ring_free(&p->ready_batches);
+}
+
+static void executor_totals(struct worker *executors, int count, size_t *archives, unsigned long long *latency_us,
+                            unsigned long long *latency_us2)
+{
+    *archives = 0;
+    *latency_us = 0;
+    *latency_us2 = 0;
+    for (int i = 0; i < count; i++)
+    {
+        *archives += __atomic_load_n(&executors[i].archives, __ATOMIC_RELAXED);
+        *latency_us += __atomic_load_n(&executors[i].latency_us, __ATOMIC_RELAXED);
+        *latency_us2 += __atomic_load_n(&executors[i].latency_us2, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * @brief Does the count just tried beat the best one? One more executor has
+ * to bring CONTROL_GAIN more throughput without the latency spreading out,
+ * which is how cache and scheduler thrashing shows before throughput drops.
+ * One less only has to keep the throughput, or nearly so if it also
+ * tightens the latency.
+ */
+static int controller_better(const struct controller *c, double rate, double cv)
+{
+    if (c->active > c->best)
+        return rate > c->best_rate * (1 + CONTROL_GAIN) && cv <= c->best_cv * CONTROL_CV_GROWTH + CONTROL_CV_FLOOR;
+    return rate >= c->best_rate || (rate >= c->best_rate * (1 - CONTROL_GAIN) && cv * CONTROL_CV_GROWTH < c->best_cv);
+}
+
+/**
+ * @brief Move away from the best count: doubled while ramping up, else by one.
+ */
+static int controller_probe(struct controller *c, int max)
+{
+    for (int tries = 0; tries < 2; tries++)
+    {
+        int step = c->ramping && c->direction > 0 ? c->active : 1;
+        int next = c->active + c->direction * step;
+        if (next > max)
+            next = max;
+        if (next < 1)
+            next = 1;
+        if (next != c->active)
+            return next;
+        c->direction = -c->direction;
+        c->ramping = 0;
+    }
+    return c->active;
+}
+
+/**
+ * @brief Take one sample of throughput and latency spread at the current
+ * count and pick the next count.
+ */
+static int controller_step(struct controller *c, double rate, double cv, int max, int quiet)
+{
+    if (c->active == c->best)
+    {
+        // Measure the best count again every time: the load may have changed
+        c->best_rate = rate;
+        c->best_cv = cv;
+        if (c->hold > 0)
+        {
+            c->hold--;
+            return c->active;
+        }
+        return controller_probe(c, max);
+    }
+    if (controller_better(c, rate, cv))
+    {
+        if (!quiet)
+            printf("Controller: %d -> %d executors, %.0f -> %.0f execs/s, latency spread %.2f\n", c->best, c->active,
+                   c->best_rate, rate, cv);
+        c->best = c->active;
+        c->best_rate = rate;
+        c->best_cv = cv;
+        c->rejected = 0;
+        return controller_probe(c, max);
+    }
+    c->ramping = 0;
+    c->direction = -c->direction;
+    if (++c->rejected >= 2)
+    {
+        c->rejected = 0;
+        c->hold = CONTROL_HOLD;
+    }
+    return c->best;
+}
+
+/**
+ * @brief Adjust the number of running executors until they are all done.
+ *
+ * Every PIPELINE_CONTROL_INTERVAL the aggregate execs/sec and the spread of
+ * per-archive latency (standard deviation over mean) of the last interval
+ * decide whether the count just tried is kept. Executors above the count
+ * park between batches.
+ */
+static void control(struct pipeline *p, struct worker *executors, int count, struct pipeline_stats *stats)
+{
+    struct controller c;
+    memset(&c, 0, sizeof(c));
+    c.active = 1;
+    c.best = 1;
+    c.direction = 1;
+    c.ramping = 1;
+    c.at = now();
+    double last = c.at;
+    __atomic_store_n(&p->active_executors, c.active, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&p->executors_running, __ATOMIC_ACQUIRE) > 0)
+    {
+        struct timespec ts = {0, (long)(PIPELINE_CONTROL_INTERVAL * 1e9)};
+        nanosleep(&ts, NULL);
+        double t = now();
+        c.active_time += c.active * (t - last);
+        last = t;
+        size_t archives;
+        unsigned long long latency_us, latency_us2;
+        executor_totals(executors, count, &archives, &latency_us, &latency_us2);
+        size_t n = archives - c.archives;
+        if (n < CONTROL_MIN_ARCHIVES)
+            continue;
+        double mean = (double)(latency_us - c.latency_us) / n;
+        double variance = (double)(latency_us2 - c.latency_us2) / n - mean * mean;
+        double cv = mean > 0 && variance > 0 ? sqrt(variance) / mean : 0;
+        int next = controller_step(&c, n / (t - c.at), cv, count, p->config->quiet);
+        c.at = t;
+        c.archives = archives;
+        c.latency_us = latency_us;
+        c.latency_us2 = latency_us2;
+        c.active = next;
+        __atomic_store_n(&p->active_executors, next, __ATOMIC_RELAXED);
+    }
+    stats->executors_mean = c.active_time / (now() - p->start);
+    stats->executors_settled = c.best;
+}
+
+/**
+ * @brief Generate and execute mutated archives with generator and executor
+ * threads connected by two lock-free rings of batches.
+ *
+ * Generators take empty batches from one ring and queue full ones on the
+ * other; executors do the reverse. A bounded number of batches gives
+ * backpressure: generators stall, not executors, when extraction is the
+ * bottleneck. Crash files are numbered after the crashes already in
+ * test_status, which is updated at the end. With config->adaptive, a
+ * controller on the calling thread decides how many executors run.
+ *
+ * @return 0, or -1 if the pipeline could not be set up.
+ */
+int pipeline_run(const struct pipeline_config *config, struct pipeline_stats *stats)
+{
+    memset(stats, 0, sizeof(struct pipeline_stats));
+    if (config->generators < 1 || config->executors < 1 ||
+        config->generators + config->executors > PIPELINE_MAX_THREADS)
+        return -1;
+    struct pipeline p;
+    if (setup(&p, config) == -1)
+    {
+        teardown(&p);
+        return -1;
+    }
+
+    struct worker workers[PIPELINE_MAX_THREADS];
+    int threads = config->generators + config->executors;
+    memset(workers, 0, sizeof(workers));
+    double start = now();
+    p.start = start;
+    p.deadline = start + config->seconds;
+    p.generators_running = config->generators;
+    p.executors_running = config->executors;
+    p.active_executors = config->adaptive ? 1 : config->executors;
+    int started = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        int generator = i < config->generators;
+        workers[i].p = &p;
+        workers[i].index = generator ? i : i - config->generators;
+        if (pthread_create(&workers[i].thread, NULL, generator ? generator_main : executor_main, &workers[i]) != 0)
+        {
+            perror("pthread_create");
+            if (generator)
+                __atomic_sub_fetch(&p.generators_running, config->generators - i, __ATOMIC_RELEASE);
+            int first_missing = generator ? config->generators : i;
+            __atomic_sub_fetch(&p.executors_running, threads - first_missing, __ATOMIC_RELEASE);
+            break;
+        }
+        started++;
+    }
+    stats->executors_mean = config->executors;
+    stats->executors_settled = config->executors;
+    if (config->adaptive && started == threads)
+        control(&p, workers + config->generators, config->executors, stats);
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i].thread, NULL);
+    stats->elapsed = now() - start;
+
+    size_t ready_samples = 0;
+    double executor_time = 0;
+    unsigned long long latency_us = 0, latency_us2 = 0;
+    for (int i = 0; i < started; i++)
+    {
+        if (i < config->generators)
+        {
+            stats->generator_busy += workers[i].busy / stats->elapsed / config->generators;
+            stats->generator_blocked += workers[i].waiting / stats->elapsed / config->generators;
+            continue;
+        }
+        // Time parked by the controller is neither busy nor starved, and an
+        // executor is only accounted for until it left, so the two add up
+        stats->executor_busy += workers[i].busy;
+        stats->executor_starved += workers[i].waiting;
+        executor_time += workers[i].exited - start - workers[i].parked;
+        latency_us += workers[i].latency_us;
+        latency_us2 += workers[i].latency_us2;
+        stats->archives += workers[i].archives;
+        stats->crashes += workers[i].crashes;
+        stats->ready_batches += workers[i].ready_sum;
+        ready_samples += workers[i].ready_samples;
+    }
+    if (ready_samples > 0)
+        stats->ready_batches /= ready_samples;
+    if (executor_time > 0)
+    {
+        stats->executor_busy /= executor_time;
+        stats->executor_starved /= executor_time;
+    }
+    if (stats->archives > 0)
+    {
+        double mean = (double)latency_us / stats->archives;
+        double variance = (double)latency_us2 / stats->archives - mean * mean;
+        stats->latency = mean / 1e6;
+        stats->latency_deviation = variance > 0 ? sqrt(variance) / 1e6 : 0;
+    }
+    test_status.number_of_tries += stats->archives;
+    test_status.number_of_tar_created += stats->archives;
+    test_status.number_of_success += stats->crashes;
+    teardown(&p);
+    return 0;
+}
+
+void pipeline_print_stats(const struct pipeline_config *config, const struct pipeline_stats *stats)
+{
+    printf("Pipeline: %zu archives in %.2fs (%.0f execs/s), %zu crashes\n", stats->archives, stats->elapsed,
+           stats->elapsed > 0 ? stats->archives / stats->elapsed : 0.0, stats->crashes);
+    printf("  executors  x%-3d busy %5.1f%%  starved %5.1f%%\n", config->executors, 100 * stats->executor_busy,
+           100 * stats->executor_starved);
+    if (config->adaptive)
+        printf("  controller settled on %d executors, %.1f running on average\n", stats->executors_settled,
+               stats->executors_mean);
+    printf("  latency    %.2f ms +- %.2f ms per archive\n", 1e3 * stats->latency, 1e3 * stats->latency_deviation);
+    printf("  generators x%-3d busy %5.1f%%  blocked %5.1f%%\n", config->generators, 100 * stats->generator_busy,
+           100 * stats->generator_blocked);
+    printf("  ready batches when taken: %.1f on average\n", stats->ready_batches);
+}
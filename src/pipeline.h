@@ -0,0 +1,45 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+#include <stddef.h>
+#include "corpus.h"
+
+#define PIPELINE_MAX_THREADS 64
+#define PIPELINE_BATCH 8 /* archives handed from a generator to an executor at once */
+#define PIPELINE_CONTROL_INTERVAL 0.25 /* seconds between two adaptive controller samples */
+
+struct pipeline_config
+{
+    const char *extractor;
+    size_t archives;      /* stop after this many archives, 0 for no limit */
+    double seconds;       /* stop after this long, 0 for no limit */
+    int generators;
+    int executors;        /* with adaptive, the most that may run at once */
+    int adaptive;         /* let a controller pick how many executors run */
+    int pin;              /* pin executors, and the extractors they start, to one CPU each */
+    struct corpus *seeds; /* optional: mutate seed headers too */
+    const struct tar_dictionary *dictionary; /* optional: tokens for the mutators */
+    unsigned long long seed;
+    int quiet;            /* do not announce crash files */
+};
+
+/* Where the time went, as fractions of the run per stage */
+struct pipeline_stats
+{
+    size_t archives;
+    size_t crashes;
+    double elapsed;
+    double executor_busy;     /* writing archives and waiting for the extractor */
+    double executor_starved;  /* waiting for a generator */
+    double generator_busy;
+    double generator_blocked; /* waiting for a free batch: backpressure */
+    double ready_batches;     /* average batches queued when an executor took one */
+    double latency;           /* mean seconds per archive, as seen by an executor */
+    double latency_deviation;
+    double executors_mean;    /* executors running, averaged over the run */
+    int executors_settled;    /* the count the controller ended on */
+};
+
+int pipeline_run(const struct pipeline_config *config, struct pipeline_stats *stats);
+void pipeline_print_stats(const struct pipeline_config *config, const struct pipeline_stats *stats);
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdlib.h>
+#include "ring.h"
+
+/**
+ * @brief Allocate a ring of at least @p capacity cells, rounded up to a power of two.
+ * @return 0, or -1 on allocation failure.
+ */
+int ring_init(struct ring *r, size_t capacity)
+{
+    size_t size = 2;
+    while (size < capacity)
+        size *= 2;
+    r->cells = malloc(size * sizeof(struct ring_cell));
+    if (!r->cells)
+        return -1;
+    for (size_t i = 0; i < size; i++)
+        r->cells[i].sequence = i;
+    r->mask = size - 1;
+    r->head = 0;
+    r->tail = 0;
+    return 0;
+}
+
+void ring_free(struct ring *r)
+{
+    free(r->cells);
+    r->cells = NULL;
+}
+
+/**
+ * @brief Push without blocking.
+ *
+ * A cell is free for position pos once its sequence equals pos; claiming it
+ * is a single CAS on head, and publishing the value bumps the sequence so
+ * consumers see the value before the cell.
+ *
+ * @return 0, or -1 if the ring is full.
+ */
+int ring_push(struct ring *r, size_t value)
+{
+    size_t pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        struct ring_cell *cell = &r->cells[pos & r->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        long diff = (long)(sequence - pos);
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&r->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                cell->value = value;
+                __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        }
+        else if (diff < 0)
+        {
+            return -1;
+        }
+        else
+        {
+            pos = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Pop without blocking.
+ * @return 0, or -1 if the ring is empty.
+ */
+int ring_pop(struct ring *r, size_t *value)
+{
+    size_t pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        struct ring_cell *cell = &r->cells[pos & r->mask];
+        size_t sequence = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        long diff = (long)(sequence - (pos + 1));
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&r->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                *value = cell->value;
+                __atomic_store_n(&cell->sequence, pos + r->mask + 1, __ATOMIC_RELEASE);
+                return 0;
+            }
+        }
+        else if (diff < 0)
+        {
+            return -1;
+        }
+        else
+        {
+            pos = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/**
+ * @brief Number of queued values; only a snapshot while others push and pop.
+ */
+size_t ring_size(struct ring *r)
+{
+    size_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    return head > tail ? head - tail : 0;
+}
@@ -0,0 +1,30 @@
+#ifndef RING_H
+#define RING_H
+#include <stddef.h>
+
+#define RING_CACHE_LINE 64
+
+struct ring_cell
+{
+    size_t sequence;
+    size_t value;
+};
+
+/* Bounded lock-free MPMC queue of indices (Vyukov's sequence-per-cell
+ * design). Producers and consumers only contend on their own counter, each
+ * on its own cache line. */
+struct ring
+{
+    struct ring_cell *cells;
+    size_t mask;
+    size_t head __attribute__((aligned(RING_CACHE_LINE))); /* next cell to push */
+    size_t tail __attribute__((aligned(RING_CACHE_LINE))); /* next cell to pop */
+};
+
+int ring_init(struct ring *r, size_t capacity);
+void ring_free(struct ring *r);
+int ring_push(struct ring *r, size_t value);
+int ring_pop(struct ring *r, size_t *value);
+size_t ring_size(struct ring *r);
+
+#endif
@@ -0,0 +1,666 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "utils.h"
+#include "executor.h"
+#include "snapshot.h"
+
+static int enabled;
+
+#if defined(__x86_64__)
+#include <stddef.h>
+#include <sys/ptrace.h>
+#include <sys/user.h>
+#include <sys/uio.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/audit.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+#define MAX_REGIONS 128
+#define MAX_SNAPSHOT_FDS 64
+#define SYSCALL_INSN_LENGTH 2     /* "syscall" is 0f 05 */
+#define SCRATCH_OFFSET 1024       /* below the snapshot stack pointer, well past the red zone */
+#define KERNEL_SIGSET_SIZE 8
+
+/* A writable mapping and its content at snapshot time */
+struct region
+{
+    unsigned long start;
+    unsigned long end;
+    char perms[5];
+    int heap;
+    int stack;
+    char *data;
+};
+
+/* struct sigaction as rt_sigaction() takes it, not as glibc declares it */
+struct kernel_sigaction
+{
+    unsigned long handler;
+    unsigned long flags;
+    unsigned long restorer;
+    unsigned long mask;
+};
+
+struct snapshot_target
+{
+    pid_t pid;
+    int out_fd; /* the target's stdout, a memfd */
+    char extractor[4096];
+    char archive_path[32];
+    char sandbox[32];
+    struct user_regs_struct regs; /* at the entry of the syscall opening the archive */
+    struct user_fpregs_struct fpregs;
+    unsigned long long sigmask;
+    struct kernel_sigaction actions[NSIG];
+    struct region layout[MAX_REGIONS]; /* every mapping, for spotting new ones */
+    size_t layout_count;
+    struct region regions[MAX_REGIONS]; /* the writable ones, with their content */
+    size_t region_count;
+    int fds[MAX_SNAPSHOT_FDS];
+    size_t fd_count;
+    unsigned long heap_end; /* 0 if there was no heap yet */
+};
+
+static struct snapshot_target target = {.pid = -1, .out_fd = -1};
+
+/* Signals that end the extractor unless it handles them */
+static const int fatal_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT, SIGSYS};
+#define FATAL_SIGNAL_COUNT (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+
+static int wait_target(int *status)
+{
+    while (waitpid(target.pid, status, __WALL) == -1)
+    {
+        if (errno != EINTR)
+            return -1;
+    }
+    return 0;
+}
+
+static int seccomp_stop(int status)
+{
+    return WIFSTOPPED(status) && (status >> 8) == (SIGTRAP | (PTRACE_EVENT_SECCOMP << 8));
+}
+
+static void kill_target(void)
+{
+    if (target.pid == -1)
+        return;
+    kill(target.pid, SIGKILL);
+    int status;
+    wait_target(&status);
+    target.pid = -1;
+    for (size_t i = 0; i < target.region_count; i++)
+        free(target.regions[i].data);
+    target.region_count = 0;
+}
+
+/**
+ * @brief Leave a syscall-entry (seccomp) stop without running the syscall.
+ *
+ * Skipping the syscall and stopping at its exit gives a stop where the
+ * registers can be rewritten freely, as for a signal-delivery stop.
+ */
+static int skip_syscall(void)
+{
+    struct user_regs_struct regs;
+    if (ptrace(PTRACE_GETREGS, target.pid, NULL, &regs) == -1)
+        return -1;
+    regs.orig_rax = -1;
+    if (ptrace(PTRACE_SETREGS, target.pid, NULL, &regs) == -1 || ptrace(PTRACE_SYSCALL, target.pid, NULL, NULL) == -1)
+        return -1;
+    int status;
+    if (wait_target(&status) == -1 || !WIFSTOPPED(status) || WSTOPSIG(status) != (SIGTRAP | 0x80))
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Run one syscall in the stopped target by single-stepping over the
+ * syscall instruction of the snapshot point.
+ * @return The syscall's return value, or -1 with errno set if ptrace fails.
+ */
+static long inject_syscall(long nr, unsigned long a1, unsigned long a2, unsigned long a3, unsigned long a4)
+{
+    struct user_regs_struct regs = target.regs;
+    regs.rip -= SYSCALL_INSN_LENGTH;
+    regs.orig_rax = -1;
+    regs.rax = nr;
+    regs.rdi = a1;
+    regs.rsi = a2;
+    regs.rdx = a3;
+    regs.r10 = a4;
+    if (ptrace(PTRACE_SETREGS, target.pid, NULL, &regs) == -1 ||
+        ptrace(PTRACE_SINGLESTEP, target.pid, NULL, NULL) == -1)
+        return -1;
+    int status;
+    if (wait_target(&status) == -1 || !WIFSTOPPED(status) || WSTOPSIG(status) != SIGTRAP)
+    {
+        errno = ECHILD;
+        return -1;
+    }
+    if (ptrace(PTRACE_GETREGS, target.pid, NULL, &regs) == -1)
+        return -1;
+    return regs.rax;
+}
+
+static int read_target(unsigned long address, void *buf, size_t length)
+{
+    struct iovec local = {buf, length};
+    struct iovec remote = {(void *)address, length};
+    return process_vm_readv(target.pid, &local, 1, &remote, 1, 0) == (ssize_t)length ? 0 : -1;
+}
+
+static int write_target(unsigned long address, const void *buf, size_t length)
+{
+    struct iovec local = {(void *)buf, length};
+    struct iovec remote = {(void *)address, length};
+    return process_vm_writev(target.pid, &local, 1, &remote, 1, 0) == (ssize_t)length ? 0 : -1;
+}
+
+/**
+ * @brief Parse /proc/<pid>/maps into @p regions.
+ * @return Number of mappings, or -1 if there are too many or maps is unreadable.
+ */
+static int read_maps(struct region *regions, size_t max)
+{
+    char path[64], line[512];
+    snprintf(path, sizeof(path), "/proc/%d/maps", (int)target.pid);
+    FILE *maps = fopen(path, "r");
+    if (!maps)
+        return -1;
+    size_t count = 0;
+    while (fgets(line, sizeof(line), maps))
+    {
+        if (count == max)
+        {
+            fclose(maps);
+            return -1;
+        }
+        struct region *r = &regions[count];
+        memset(r, 0, sizeof(struct region));
+        if (sscanf(line, "%lx-%lx %4s", &r->start, &r->end, r->perms) != 3)
+            continue;
+        r->heap = strstr(line, "[heap]") != NULL;
+        r->stack = strstr(line, "[stack]") != NULL;
+        count++;
+    }
+    fclose(maps);
+    return (int)count;
+}
+
+static int list_fds(int *fds, size_t max)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd", (int)target.pid);
+    DIR *dir = opendir(path);
+    if (!dir)
+        return -1;
+    struct dirent *de;
+    size_t count = 0;
+    while ((de = readdir(dir)) != NULL && count < max)
+    {
+        if (de->d_name[0] != '.')
+            fds[count++] = atoi(de->d_name);
+    }
+    closedir(dir);
+    return (int)count;
+}
+
+/**
+ * @brief Start the extractor under ptrace and stop it at the syscall that
+ * opens the archive.
+ *
+ * A seccomp filter turns open(at) and exit(_group) into ptrace stops, so
+ * the target runs at full speed in between and needs no breakpoint.
+ */
+static int spawn_target(void)
+{
+    struct sock_filter filter[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AUDIT_ARCH_X86_64, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_open, 4, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_openat, 3, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_exit_group, 2, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_exit, 1, 0),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_TRACE),
+    };
+    struct sock_fprog program = {sizeof(filter) / sizeof(filter[0]), filter};
+
+    target.pid = fork();
+    if (target.pid == -1)
+        return -1;
+    if (target.pid == 0)
+    {
+        dup2(target.out_fd, STDOUT_FILENO);
+        int devnull = open("/dev/null", O_RDWR);
+        if (devnull != -1)
+        {
+            dup2(devnull, STDIN_FILENO);
+            dup2(devnull, STDERR_FILENO);
+            close(devnull);
+        }
+        if (chdir(target.sandbox) == -1 || ptrace(PTRACE_TRACEME, 0, NULL, NULL) == -1)
+            _exit(127);
+        raise(SIGSTOP); // lets the parent set PTRACE_O_TRACESECCOMP before the filter can fire
+        if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == -1 || prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program) == -1)
+            _exit(127);
+        char *argv[] = {target.extractor, target.archive_path, NULL};
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    int status;
+    if (wait_target(&status) == -1 || !WIFSTOPPED(status))
+        return -1;
+    long options = PTRACE_O_TRACESECCOMP | PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL;
+    if (ptrace(PTRACE_SETOPTIONS, target.pid, NULL, options) == -1)
+        return -1;
+    int signal = 0;
+    for (;;)
+    {
+        if (ptrace(PTRACE_CONT, target.pid, NULL, signal) == -1 || wait_target(&status) == -1 || !WIFSTOPPED(status))
+            return -1;
+        signal = 0;
+        if (!seccomp_stop(status))
+        {
+            if (WSTOPSIG(status) != SIGTRAP) // the exec SIGTRAP is ours
+                signal = WSTOPSIG(status);
+            continue;
+        }
+        if (ptrace(PTRACE_GETREGS, target.pid, NULL, &target.regs) == -1)
+            return -1;
+        if (target.regs.orig_rax != __NR_open && target.regs.orig_rax != __NR_openat)
+            return -1; // exited before opening the archive
+        char path[sizeof(target.archive_path)] = {0};
+        unsigned long address = target.regs.orig_rax == __NR_openat ? target.regs.rsi : target.regs.rdi;
+        if (read_target(address, path, strlen(target.archive_path) + 1) == 0 &&
+            strcmp(path, target.archive_path) == 0)
+            return 0;
+    }
+}
+
+/**
+ * @brief Save what a run can change: registers, signal mask and handlers,
+ * the content of every writable mapping and the open fds.
+ */
+static int take_snapshot(void)
+{
+    if (ptrace(PTRACE_GETFPREGS, target.pid, NULL, &target.fpregs) == -1 ||
+        ptrace(PTRACE_GETSIGMASK, target.pid, (void *)KERNEL_SIGSET_SIZE, &target.sigmask) == -1 ||
+        skip_syscall() == -1)
+        return -1;
+
+    unsigned long scratch = target.regs.rsp - SCRATCH_OFFSET;
+    for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++)
+    {
+        int sig = fatal_signals[i];
+        if (inject_syscall(__NR_rt_sigaction, sig, 0, scratch, KERNEL_SIGSET_SIZE) != 0 ||
+            read_target(scratch, &target.actions[sig], sizeof(struct kernel_sigaction)) == -1)
+            return -1;
+    }
+
+    int count = read_maps(target.layout, MAX_REGIONS);
+    if (count == -1)
+        return -1;
+    target.layout_count = count;
+    for (int i = 0; i < count; i++)
+    {
+        if (target.layout[i].heap)
+            target.heap_end = target.layout[i].end;
+        if (target.layout[i].perms[0] != 'r' || target.layout[i].perms[1] != 'w')
+            continue;
+        struct region *r = &target.regions[target.region_count];
+        *r = target.layout[i];
+        r->data = malloc(r->end - r->start);
+        if (!r->data)
+            return -1;
+        target.region_count++;
+        if (read_target(r->start, r->data, r->end - r->start) == -1)
+            return -1;
+    }
+
+    int fds = list_fds(target.fds, MAX_SNAPSHOT_FDS);
+    if (fds == -1)
+        return -1;
+    target.fd_count = fds;
+    return 0;
+}
+
+/**
+ * @brief Put the target back at the open of the archive, ready to re-execute it.
+ */
+static int rewind_target(void)
+{
+    struct user_regs_struct regs = target.regs;
+    regs.rip -= SYSCALL_INSN_LENGTH;
+    regs.rax = regs.orig_rax;
+    regs.orig_rax = -1;
+    if (ptrace(PTRACE_SETSIGMASK, target.pid, (void *)KERNEL_SIGSET_SIZE, &target.sigmask) == -1 ||
+        ptrace(PTRACE_SETFPREGS, target.pid, NULL, &target.fpregs) == -1 ||
+        ptrace(PTRACE_SETREGS, target.pid, NULL, &regs) == -1)
+        return -1;
+    return 0;
+}
+
+static int start_target(void)
+{
+    if (spawn_target() == -1 || take_snapshot() == -1 || rewind_target() == -1)
+    {
+        kill_target();
+        return -1;
+    }
+    return 0;
+}
+
+static int overlaps(const struct region *r)
+{
+    for (size_t i = 0; i < target.layout_count; i++)
+    {
+        if (r->start < target.layout[i].end && target.layout[i].start < r->end)
+            return 1;
+    }
+    return 0;
+}
+
+static int known_mapping(const struct region *m)
+{
+    for (size_t i = 0; i < target.layout_count; i++)
+    {
+        const struct region *r = &target.layout[i];
+        // The stack may have grown down, which changes its start only
+        if (m->end == r->end && strcmp(m->perms, r->perms) == 0 && (m->start == r->start || (m->stack && r->stack)))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Undo the mappings and fds a run created.
+ *
+ * New mappings are unmapped and the heap is set back with brk(), so memory
+ * malloc gets from the kernel again is zeroed as it expects. A run that
+ * changed a snapshot mapping cannot be undone this way.
+ */
+static int restore_layout(void)
+{
+    int fds[MAX_SNAPSHOT_FDS * 2];
+    int fd_count = list_fds(fds, MAX_SNAPSHOT_FDS * 2);
+    for (int i = 0; i < fd_count; i++)
+    {
+        int known = 0;
+        for (size_t j = 0; j < target.fd_count && !known; j++)
+            known = fds[i] == target.fds[j];
+        if (!known && inject_syscall(__NR_close, fds[i], 0, 0, 0) == -1 && errno != EBADF)
+            return -1;
+    }
+
+    struct region maps[MAX_REGIONS];
+    int count = read_maps(maps, MAX_REGIONS);
+    if (count == -1)
+        return -1;
+    for (int i = 0; i < count; i++)
+    {
+        struct region *m = &maps[i];
+        if (known_mapping(m))
+            continue;
+        if (m->heap)
+        {
+            if (inject_syscall(__NR_brk, target.heap_end ? target.heap_end : m->start, 0, 0, 0) == -1)
+                return -1;
+        }
+        else if (overlaps(m) || inject_syscall(__NR_munmap, m->start, m->end - m->start, 0, 0) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Write back the snapshot content of all writable memory.
+ *
+ * Soft-dirty tracking would let this copy only the pages the run touched,
+ * but pagemap misses some of them (seen with pages of libc's data), and one
+ * stale page there made every later run abort with "stack smashing
+ * detected". The regions total a few hundred KB: one process_vm_writev().
+ */
+static int restore_memory(void)
+{
+    struct iovec local[MAX_REGIONS], remote[MAX_REGIONS];
+    for (size_t i = 0; i < target.region_count; i++)
+    {
+        struct region *r = &target.regions[i];
+        local[i].iov_base = r->data;
+        local[i].iov_len = r->end - r->start;
+        remote[i].iov_base = (void *)r->start;
+        remote[i].iov_len = r->end - r->start;
+    }
+    if (process_vm_writev(target.pid, local, target.region_count, remote, target.region_count, 0) == -1)
+        return -1;
+    return 0;
+}
+
+/**
+ * @brief Reinstall the handlers of signals delivered during the run, which
+ * may have been reset by SA_RESETHAND (as signal() sets it up).
+ */
+static int restore_handlers(const int *delivered)
+{
+    unsigned long scratch = target.regs.rsp - SCRATCH_OFFSET;
+    for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++)
+    {
+        int sig = fatal_signals[i];
+        if (!delivered[sig])
+            continue;
+        if (write_target(scratch, &target.actions[sig], sizeof(struct kernel_sigaction)) == -1 ||
+            inject_syscall(__NR_rt_sigaction, sig, scratch, 0, KERNEL_SIGSET_SIZE) != 0)
+            return -1;
+    }
+    return 0;
+}
+
+static void read_output(struct exec_result *res)
+{
+    ssize_t n = pread(target.out_fd, res->first_line, sizeof(res->first_line) - 1, 0);
+    if (n < 0)
+        n = 0;
+    char *newline = memchr(res->first_line, '\n', n);
+    if (newline)
+    {
+        n = newline - res->first_line + 1;
+        res->line_complete = 1;
+    }
+    res->first_line[n] = '\0';
+    res->line_length = n;
+    res->crashed = strncmp(res->first_line, CRASH_MESSAGE, sizeof(CRASH_MESSAGE)) == 0;
+}
+
+/**
+ * @brief Run the archive in archive_fd through the snapshot, then restore it.
+ *
+ * The target resumes at the open of the archive and runs until it calls
+ * exit or hits a fatal signal it does not handle. Signals the extractor
+ * handles (its SIGSEGV handler prints CRASH_MESSAGE) are delivered, so
+ * crashes are detected from the first output line exactly as by
+ * run_extractor(). If the target cannot be restored it is killed and
+ * started again on the next run.
+ */
+int snapshot_execute(struct exec_result *res)
+{
+    memset(res, 0, sizeof(struct exec_result));
+    if (target.pid == -1 && start_target() == -1)
+        return -1;
+    if (ftruncate(target.out_fd, 0) == -1 || lseek(target.out_fd, 0, SEEK_SET) == -1)
+        return -1;
+
+    int delivered[NSIG] = {0};
+    int signal = 0, status, alive = 1;
+    for (;;)
+    {
+        if (ptrace(PTRACE_CONT, target.pid, NULL, signal) == -1 || wait_target(&status) == -1)
+            return -1;
+        signal = 0;
+        if (!WIFSTOPPED(status))
+        {
+            res->exited = WIFEXITED(status);
+            res->exit_code = res->exited ? WEXITSTATUS(status) : 0;
+            res->signaled = WIFSIGNALED(status);
+            res->signal = res->signaled ? WTERMSIG(status) : 0;
+            alive = 0;
+            break;
+        }
+        if (seccomp_stop(status))
+        {
+            struct user_regs_struct regs;
+            if (ptrace(PTRACE_GETREGS, target.pid, NULL, &regs) == -1)
+                return -1;
+            if (regs.orig_rax != __NR_exit_group && regs.orig_rax != __NR_exit)
+                continue;
+            res->exited = 1;
+            res->exit_code = regs.rdi & 0xFF;
+            alive = skip_syscall() == 0;
+            break;
+        }
+        int sig = WSTOPSIG(status);
+        if (sig == (SIGTRAP | 0x80))
+            continue;
+        int fatal = 0;
+        for (size_t i = 0; i < FATAL_SIGNAL_COUNT; i++)
+            fatal |= sig == fatal_signals[i];
+        if (fatal && target.actions[sig].handler > (unsigned long)SIG_IGN && !delivered[sig])
+        {
+            delivered[sig] = 1;
+            signal = sig;
+            continue;
+        }
+        if (fatal)
+        {
+            res->signaled = 1; // suppressed: the process would have died here
+            res->signal = sig;
+            break;
+        }
+        signal = sig;
+    }
+
+    read_output(res);
+    exec_clear_directory(target.sandbox);
+    if (!alive || restore_layout() == -1 || restore_handlers(delivered) == -1 ||
+        restore_memory() == -1 || rewind_target() == -1)
+        kill_target();
+    return 0;
+}
+
+/**
+ * @brief Set up snapshot mode: archives go to a memfd the extractor opens
+ * as /proc/self/fd/N, and the extractor is started and snapshotted once.
+ */
+int snapshot_init(const char *extractor_path)
+{
+    if (!realpath(extractor_path, target.extractor))
+    {
+        perror(extractor_path);
+        return -1;
+    }
+    archive_fd = memfd_create("archive.tar", 0);
+    target.out_fd = memfd_create("extractor.out", MFD_CLOEXEC);
+    if (archive_fd == -1 || target.out_fd == -1)
+    {
+        perror("memfd_create");
+        return -1;
+    }
+    snprintf(target.archive_path, sizeof(target.archive_path), "/proc/self/fd/%d", archive_fd);
+    snprintf(target.sandbox, sizeof(target.sandbox), "sandbox_snapshot");
+    if (mkdir(target.sandbox, 0755) == -1 && errno != EEXIST)
+    {
+        perror(target.sandbox);
+        return -1;
+    }
+    exec_clear_directory(target.sandbox);
+    if (start_target() == -1)
+    {
+        printf("Unable to snapshot %s under ptrace\n", target.extractor);
+        return -1;
+    }
+    enabled = 1;
+    return 0;
+}
+
+void snapshot_cleanup(void)
+{
+    kill_target();
+    if (enabled)
+        rmdir(target.sandbox);
+    if (target.out_fd != -1)
+        close(target.out_fd);
+    target.out_fd = -1;
+    if (archive_fd != -1)
+        close(archive_fd);
+    archive_fd = -1;
+    enabled = 0;
+}
+
+#else
+
+int snapshot_init(const char *extractor_path)
+{
+    printf("Snapshot mode needs x86-64, %s runs as usual\n", extractor_path);
+    return -1;
+}
+
+int snapshot_execute(struct exec_result *res)
+{
+    memset(res, 0, sizeof(struct exec_result));
+    return -1;
+}
+
+void snapshot_cleanup(void)
+{
+}
+
+#endif
+
+int snapshot_enabled(void)
+{
+    return enabled;
+}
+
+/**
+ * @brief run_extractor() for snapshot mode.
+ * @return 1 if the extractor crashed, 0 if not, -1 if it could not run.
+ */
+int snapshot_run(void)
+{
+    test_status.number_of_tries++;
+    struct exec_result res;
+    if (snapshot_execute(&res) == -1)
+        return -1;
+    if (res.crashed)
+    {
+        test_status.number_of_success++;
+        char success_name[32];
+        snprintf(success_name, sizeof(success_name), "success_%d.tar", test_status.number_of_success);
+        tar_archive_save(success_name);
+        printf("Saved crash file: %s\n", success_name);
+    }
+    else if (res.line_length > 0)
+    {
+        printf("Extractor output: '%s'\n", res.first_line);
+    }
+    return res.crashed;
+}
@@ -0,0 +1,11 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "executor.h"
+
+int snapshot_init(const char *extractor_path);
+int snapshot_enabled(void);
+int snapshot_execute(struct exec_result *res);
+int snapshot_run(void);
+void snapshot_cleanup(void);
+
+#endif
@@ -0,0 +1,372 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include "utils.h"
+#include "executor.h"
+#include "numfield.h"
+#include "stream.h"
+
+#define STREAM_SEGMENT (64 * 1024)      /* size of the shared zero and payload regions */
+#define STREAM_PIPE_SIZE (1024 * 1024)  /* requested pipe capacity */
+#define STREAM_BATCH 64                 /* iovecs handed to the kernel per call */
+#define STREAM_MAX_ARGS 16
+#define STREAM_SANDBOX "sandbox_stream"
+
+struct stream_ctx
+{
+    int pipe_fd;
+    int out_fd;
+    int use_vmsplice;
+    int broken; /* the target stopped reading */
+    struct iovec batch[STREAM_BATCH];
+    int batch_count;
+    unsigned long long bytes;
+    struct exec_result *res;
+};
+
+static int compare_indices(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+    return x < y ? -1 : x > y;
+}
+
+/**
+ * @brief Parse a comma separated list of entry indices, e.g. "0,5000,49999".
+ */
+int stream_parse_mutations(struct stream_plan *plan, const char *list)
+{
+    const char *p = list;
+    while (*p)
+    {
+        char *end;
+        unsigned long index = strtoul(p, &end, 10);
+        if (end == p || plan->mutate_count >= MAX_STREAM_MUTATIONS)
+        {
+            printf("Bad mutation list: %s\n", list);
+            return -1;
+        }
+        plan->mutate[plan->mutate_count++] = index;
+        p = *end == ',' ? end + 1 : end;
+        if (*end && *end != ',')
+        {
+            printf("Bad mutation list: %s\n", list);
+            return -1;
+        }
+    }
+    qsort(plan->mutate, plan->mutate_count, sizeof(unsigned long), compare_indices);
+    return 0;
+}
+
+/**
+ * @brief Hand the pending iovecs to the pipe, draining the target's output
+ * while the pipe is full so neither side can block the other.
+ */
+static void stream_flush(struct stream_ctx *ctx)
+{
+    struct iovec *iov = ctx->batch;
+    int count = ctx->batch_count;
+    while (count > 0 && !ctx->broken)
+    {
+        struct pollfd fds[2] = {{ctx->pipe_fd, POLLOUT, 0}, {ctx->out_fd, POLLIN, 0}};
+        int nfds = ctx->out_fd == -1 ? 1 : 2;
+        if (poll(fds, nfds, -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            ctx->broken = 1;
+            break;
+        }
+        if (nfds == 2 && (fds[1].revents & (POLLIN | POLLHUP | POLLERR)))
+        {
+            if (!exec_drain(ctx->out_fd, ctx->res))
+            {
+                close(ctx->out_fd);
+                ctx->out_fd = -1;
+            }
+        }
+        if (fds[0].revents & (POLLERR | POLLHUP))
+        {
+            ctx->broken = 1;
+            break;
+        }
+        if (!(fds[0].revents & POLLOUT))
+            continue;
+
+        ssize_t n;
+        if (ctx->use_vmsplice)
+        {
+            n = vmsplice(ctx->pipe_fd, iov, count, SPLICE_F_NONBLOCK);
+            if (n == -1 && (errno == EINVAL || errno == ENOSYS))
+            {
+                ctx->use_vmsplice = 0; // e.g. seccomp or an old kernel; fall back to copies
+                continue;
+            }
+        }
+        else
+        {
+            n = writev(ctx->pipe_fd, iov, count);
+        }
+        if (n == -1)
+        {
+            if (errno == EAGAIN || errno == EINTR)
+                continue;
+            ctx->broken = 1; // EPIPE: the target exited before reading everything
+            break;
+        }
+        ctx->bytes += n;
+        while (count > 0 && (size_t)n >= iov->iov_len)
+        {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    ctx->batch_count = 0;
+}
+
+static void stream_push(struct stream_ctx *ctx, const char *data, size_t len)
+{
+    if (len == 0)
+        return;
+    if (ctx->batch_count == STREAM_BATCH)
+        stream_flush(ctx);
+    ctx->batch[ctx->batch_count].iov_base = (void *)data;
+    ctx->batch[ctx->batch_count].iov_len = len;
+    ctx->batch_count++;
+}
+
+/**
+ * @brief Push @p len bytes taken from a shared region, reusing it as often as needed.
+ */
+static void stream_push_repeated(struct stream_ctx *ctx, const char *region, unsigned long long len)
+{
+    while (len > 0 && !ctx->broken)
+    {
+        size_t chunk = len < STREAM_SEGMENT ? (size_t)len : STREAM_SEGMENT;
+        stream_push(ctx, region, chunk);
+        len -= chunk;
+    }
+}
+
+/**
+ * @brief Corrupt the header of a selected entry, cycling through the
+ * corruptions that crash the extractor on small archives.
+ */
+static void stream_mutate(tar_header *header, unsigned long index)
+{
+    switch (index % 6)
+    {
+    case 0:
+        memset(header->name, '\xFF', sizeof(header->name));
+        break;
+    case 1:
+        header->typeflag = '\x90';
+        break;
+    case 2:
+        memset(header->uid, '9', sizeof(header->uid));
+        break;
+    case 3:
+        snprintf(header->mtime, sizeof(header->mtime), "77777777777");
+        break;
+    case 4:
+        memset(header->linkname, '\xFF', sizeof(header->linkname));
+        header->typeflag = SYMTYPE;
+        break;
+    case 5:
+        tar_compute_checksum(header);
+        header->chksum[0] = '9';
+        return;
+    }
+    tar_compute_checksum(header);
+}
+
+/**
+ * @brief Stream a giant archive into a target's stdin without materialising it.
+ *
+ * Headers are built in a ring of pages that is larger than the pipe, so a slot
+ * is only rewritten once the kernel has handed its previous contents to the
+ * reader. Payload, padding and end marker all come from two shared 64 KiB
+ * regions. Memory use is therefore constant whatever the archive size.
+ *
+ * @return 1 if the target crashed, like run_extractor(), -1 if the run could
+ *         not be set up or the target stopped reading before any mutated
+ *         entry.
+ */
+int stream_run(const char *command, struct stream_plan *plan)
+{
+    char command_copy[256];
+    char *argv[STREAM_MAX_ARGS + 2];
+    snprintf(command_copy, sizeof(command_copy), "%s", command);
+    int argc = exec_split_command(command_copy, argv, STREAM_MAX_ARGS);
+    if (argc == 0)
+        return -1;
+    char resolved[256];
+    if (strchr(argv[0], '/') && argv[0][0] != '/')
+    {
+        char *path = realpath(argv[0], NULL);
+        if (path)
+        {
+            snprintf(resolved, sizeof(resolved), "%s", path);
+            argv[0] = resolved;
+            free(path);
+        }
+    }
+    argv[argc++] = "/dev/stdin";
+    argv[argc] = NULL;
+
+    int pipefd[2];
+    if (pipe(pipefd) == -1)
+    {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+    fcntl(pipefd[1], F_SETPIPE_SZ, STREAM_PIPE_SIZE);
+    long pipe_size = fcntl(pipefd[1], F_GETPIPE_SZ);
+    long page_size = sysconf(_SC_PAGESIZE);
+    if (pipe_size <= 0)
+        pipe_size = 16 * page_size;
+
+    // One header per page; a pipe never holds more buffers than pages of capacity
+    size_t ring_slots = pipe_size / page_size + STREAM_BATCH + 1;
+    char *ring = NULL, *zeros = NULL, *payload = NULL;
+    if (posix_memalign((void **)&ring, page_size, ring_slots * page_size) ||
+        posix_memalign((void **)&zeros, page_size, STREAM_SEGMENT) ||
+        posix_memalign((void **)&payload, page_size, STREAM_SEGMENT))
+    {
+        perror("posix_memalign");
+        free(ring);
+        free(zeros);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return -1;
+    }
+    memset(ring, 0, ring_slots * page_size);
+    memset(zeros, 0, STREAM_SEGMENT);
+    memset(payload, 'X', STREAM_SEGMENT);
+
+    if (mkdir(STREAM_SANDBOX, 0755) == -1 && errno != EEXIST)
+        perror(STREAM_SANDBOX);
+    struct exec_result res;
+    memset(&res, 0, sizeof(res));
+    struct stream_ctx ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.pipe_fd = pipefd[1];
+    ctx.use_vmsplice = 1;
+    ctx.res = &res;
+
+    void (*old_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+    test_status.number_of_tries++;
+    pid_t pid = exec_spawn(argv, STREAM_SANDBOX, pipefd[0], &ctx.out_fd);
+    close(pipefd[0]);
+    if (pid == -1)
+    {
+        perror("Failed to spawn stream target");
+        close(pipefd[1]);
+        signal(SIGPIPE, old_sigpipe);
+        free(ring);
+        free(zeros);
+        free(payload);
+        return -1;
+    }
+    fcntl(ctx.pipe_fd, F_SETFL, O_NONBLOCK);
+
+    struct timespec start, stop;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    unsigned long long padding = (BLOCK_SIZE - plan->entry_size % BLOCK_SIZE) % BLOCK_SIZE;
+    // 8 GiB and more does not fit 11 octal digits: GNU base-256, as GNU tar does
+    enum num_format size_format = plan->entry_size > num_field_max(sizeof(((tar_header *)0)->size), NUM_OCTAL_NUL)
+                                      ? NUM_BASE256
+                                      : NUM_OCTAL_NUL;
+    // Every entry is this case with its name patched: no per-entry full checksum
+    struct tar_case base, entry;
+    char field[sizeof(((tar_header *)0)->name)];
+    tar_case_init(&base, header_template);
+    num_encode(field, sizeof(base.header.size), plan->entry_size, size_format);
+    TAR_CASE_PATCH(&base, size, field, sizeof(base.header.size));
+    int next_mutation = 0;
+    unsigned long i;
+    for (i = 0; i < plan->entries && !ctx.broken; i++)
+    {
+        tar_header *header = (tar_header *)(ring + (i % ring_slots) * page_size);
+        entry = base;
+        int length = snprintf(field, sizeof(field), "entry_%lu", i);
+        TAR_CASE_PATCH(&entry, name, field, length + 1);
+        tar_case_finalize(&entry);
+        *header = entry.header;
+        while (next_mutation < plan->mutate_count && plan->mutate[next_mutation] < i)
+            next_mutation++;
+        if (next_mutation < plan->mutate_count && plan->mutate[next_mutation] == i)
+            stream_mutate(header, i);
+
+        stream_push(&ctx, (const char *)header, sizeof(tar_header));
+        stream_push_repeated(&ctx, payload, plan->entry_size);
+        stream_push(&ctx, zeros, padding);
+    }
+    stream_push_repeated(&ctx, zeros, END_BYTES);
+    stream_flush(&ctx);
+    close(ctx.pipe_fd);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+
+    if (ctx.out_fd != -1)
+    {
+        while (exec_drain(ctx.out_fd, &res))
+            ;
+        close(ctx.out_fd);
+    }
+    exec_finish(pid, &res);
+    signal(SIGPIPE, old_sigpipe);
+    exec_clear_directory(STREAM_SANDBOX);
+    rmdir(STREAM_SANDBOX);
+    test_status.number_of_tar_created++;
+
+    double seconds = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) / 1e9;
+    printf("Streamed %llu bytes (%lu of %lu entries) in %.2fs: %.1f MiB/s%s\n", ctx.bytes, i, plan->entries,
+           seconds, seconds > 0 ? ctx.bytes / seconds / (1024 * 1024) : 0.0,
+           ctx.use_vmsplice ? " via vmsplice" : " via writev");
+    if (res.exited)
+        printf("Target exited with status %d\n", res.exit_code);
+    else if (res.signaled)
+        printf("Target killed by signal %d\n", res.signal);
+
+    // Stopping after a corrupted header is the target rejecting it; stopping
+    // before any means it could not read the stream at all
+    int rv = res.crashed;
+    if (ctx.broken && !res.crashed && (plan->mutate_count == 0 || plan->mutate[0] >= i))
+    {
+        printf("Target stopped reading at entry %lu, before any mutated entry: run failed\n", i);
+        rv = -1;
+    }
+    if (res.crashed)
+    {
+        test_status.number_of_success++;
+        printf("Stream crashed the target; reproduce with --stream %lu --stream-size %llu", plan->entries,
+               plan->entry_size);
+        for (int i = 0; i < plan->mutate_count; i++)
+            printf("%s%lu", i == 0 ? " --stream-mutate " : ",", plan->mutate[i]);
+        printf("\n");
+    }
+    else if (res.line_length > 0)
+    {
+        printf("Extractor output: '%s'\n", res.first_line);
+    }
+
+    free(ring);
+    free(zeros);
+    free(payload);
+    return rv;
+}
@@ -0,0 +1,17 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#define MAX_STREAM_MUTATIONS 64
+
+struct stream_plan
+{
+    unsigned long entries;         /* number of entries in the archive */
+    unsigned long long entry_size; /* payload bytes of every entry */
+    unsigned long mutate[MAX_STREAM_MUTATIONS]; /* sorted entry indices to mutate */
+    int mutate_count;
+};
+
+int stream_parse_mutations(struct stream_plan *plan, const char *list);
+int stream_run(const char *command, struct stream_plan *plan);
+
+#endif
@@ -0,0 +1,134 @@
+#include <string.h>
+#include "constants.h"
+#include "sweep.h"
+
+#define PAYLOAD_VARIANTS 5
+#define PADDING_VARIANTS 4
+#define END_VARIANTS 4
+
+void tar_sweep_init(struct tar_sweep *s, unsigned long long limit)
+{
+    memset(s, 0, sizeof(struct tar_sweep));
+    s->limit = limit;
+    s->declared_index = 1; // the first boundary is 0, with nothing below it
+}
+
+static unsigned long long padding_of(unsigned long long length)
+{
+    return (BLOCK_SIZE - length % BLOCK_SIZE) % BLOCK_SIZE;
+}
+
+/**
+ * @brief Fill @p point with variant @p v for declared size @p declared.
+ * @return 0 if the variant does not exist for that size, e.g. a payload
+ *         a block shorter than a declared size under a block.
+ */
+static int make_point(unsigned long long declared, size_t v, struct tar_sweep_point *point)
+{
+    size_t payload_variant = v % PAYLOAD_VARIANTS;
+    size_t padding_variant = v / PAYLOAD_VARIANTS % PADDING_VARIANTS;
+    size_t end_variant = v / (PAYLOAD_VARIANTS * PADDING_VARIANTS) % END_VARIANTS;
+    point->sparse = v / (PAYLOAD_VARIANTS * PADDING_VARIANTS * END_VARIANTS) == 1;
+    point->declared = declared;
+
+    // As declared, one byte either way, one block either way
+    static const long long payload_delta[PAYLOAD_VARIANTS] = {0, -1, 1, -BLOCK_SIZE, BLOCK_SIZE};
+    if (payload_delta[payload_variant] < 0 && declared < (unsigned long long)-payload_delta[payload_variant])
+        return 0;
+    point->payload = declared + payload_delta[payload_variant];
+
+    // Padding for what was written, for what was declared, none, one block too much
+    switch (padding_variant)
+    {
+    case 0:
+        point->padding = padding_of(point->payload);
+        break;
+    case 1:
+        point->padding = padding_of(declared);
+        break;
+    case 2:
+        point->padding = 0;
+        break;
+    default:
+        point->padding = padding_of(point->payload) + BLOCK_SIZE;
+        break;
+    }
+
+    static const unsigned long long end_bytes[END_VARIANTS] = {END_BYTES, BLOCK_SIZE, 0, END_BYTES - 1};
+    point->end = end_bytes[end_variant];
+
+    if (point->sparse && point->payload <= BLOCK_SIZE)
+        return 0; // same bytes as not sparse
+    if (!point->sparse && point->payload > TAR_SWEEP_DENSE_LIMIT)
+        return 0; // written in full it would cost its size on every point
+    point->content = point->sparse ? BLOCK_SIZE : point->payload;
+    point->zeros = point->payload - point->content + point->padding + point->end;
+    return 1;
+}
+
+/**
+ * @brief Block count of boundary @p n: every block up to
+ * TAR_SWEEP_LINEAR_BLOCKS, then doubling, so a limit of gigabytes takes a few
+ * dozen more boundaries rather than millions.
+ */
+static unsigned long long boundary_blocks(unsigned long long n)
+{
+    if (n < TAR_SWEEP_LINEAR_BLOCKS)
+        return n;
+    unsigned long long shift = n - TAR_SWEEP_LINEAR_BLOCKS;
+    return shift < 40 ? (unsigned long long)TAR_SWEEP_LINEAR_BLOCKS << shift : ~0ULL;
+}
+
+/**
+ * @brief Next point of the sweep.
+ *
+ * Declared sizes go through block boundaries up to the limit, see
+ * boundary_blocks(), the last one being the limit rounded down to a block,
+ * and one byte either side of each. For each, the payload actually written
+ * is the declared size, one byte or one block off; it is followed by the
+ * padding of the payload or of the declared size, none, or a block too much,
+ * and by an end marker of two blocks, one, none or one byte short. Payloads
+ * over a block also come sparse: data in the first block only. Payloads
+ * over TAR_SWEEP_DENSE_LIMIT only come sparse, so the bytes written per point
+ * stay bounded whatever the limit.
+ *
+ * Padding, end marker and sparse payload tails are all zeros, so variants
+ * often end up as the same bytes; only the first of those is returned.
+ *
+ * @return 1 with @p point filled, 0 at the end of the sweep.
+ */
+int tar_sweep_next(struct tar_sweep *s, struct tar_sweep_point *point)
+{
+    for (;;)
+    {
+        unsigned long long n = s->declared_index / 3;
+        unsigned long long blocks = boundary_blocks(n);
+        unsigned long long last = s->limit / BLOCK_SIZE;
+        if (blocks > last)
+        {
+            if (n == 0 || boundary_blocks(n - 1) >= last)
+                return 0;
+            blocks = last;
+        }
+        unsigned long long boundary = blocks * BLOCK_SIZE;
+        unsigned long long declared = boundary + s->declared_index % 3 - 1;
+        if (s->variant == TAR_SWEEP_VARIANTS)
+        {
+            s->declared_index++;
+            s->variant = 0;
+            s->seen_count = 0;
+            continue;
+        }
+        if (!make_point(declared, s->variant++, point))
+            continue;
+        int seen = 0;
+        for (size_t i = 0; i < s->seen_count && !seen; i++)
+            seen = s->seen[i][0] == point->content && s->seen[i][1] == point->zeros;
+        if (seen)
+            continue;
+        s->seen[s->seen_count][0] = point->content;
+        s->seen[s->seen_count][1] = point->zeros;
+        s->seen_count++;
+        return 1;
+    }
+}
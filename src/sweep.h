@@ -0,0 +1,38 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include <stddef.h>
+
+#define TAR_SWEEP_VARIANTS 160       /* payload x padding x end marker x fill, per declared size */
+#define TAR_SWEEP_DENSE_LIMIT 4096   /* longer payloads only come sparse */
+#define TAR_SWEEP_LINEAR_BLOCKS 64   /* every block boundary up to here, then doubling */
+
+/* One archive of the sweep. declared goes into the size field; the entry is
+ * followed by payload, padding and end-marker bytes, payload being content
+ * then zeros if sparse. What is actually written is content bytes of data
+ * then zeros bytes of zeros. */
+struct tar_sweep_point
+{
+    unsigned long long declared;
+    unsigned long long payload;
+    unsigned long long padding;
+    unsigned long long end;
+    int sparse; /* only the first block of the payload has data */
+    unsigned long long content;
+    unsigned long long zeros;
+};
+
+/* Enumerates the points around block boundaries up to a limit, skipping
+ * those that would write the same bytes as an earlier one. */
+struct tar_sweep
+{
+    unsigned long long limit;
+    unsigned long long declared_index;
+    size_t variant;
+    unsigned long long seen[TAR_SWEEP_VARIANTS][2]; /* (content, zeros) written for this declared size */
+    size_t seen_count;
+};
+
+void tar_sweep_init(struct tar_sweep *s, unsigned long long limit);
+int tar_sweep_next(struct tar_sweep *s, struct tar_sweep_point *point);
+
+#endif
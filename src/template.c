@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "template.h"
+
+static struct tar_case templates[TEMPLATE_COUNT];
+static char pax_payload[64];
+static size_t pax_payload_size;
+static pthread_once_t templates_once = PTHREAD_ONCE_INIT;
+
+static const char *template_names[TEMPLATE_COUNT] = {"regular", "symlink", "dir", "pax"};
+
+/**
+ * @brief Sum the header bytes the way tar does, with chksum counted as spaces.
+ */
+unsigned int tar_header_sum(const tar_header *header)
+{
+    const unsigned char *raw = (const unsigned char *)header;
+    unsigned int sum = ' ' * CHKSUM_LENGTH;
+    for (int i = 0; i < CHKSUM_OFFSET; i++)
+        sum += raw[i];
+    for (int i = CHKSUM_OFFSET + CHKSUM_LENGTH; i < HEADER_LENGTH; i++)
+        sum += raw[i];
+    return sum;
+}
+
+/**
+ * @brief Fill in the fields shared by every template, the slow way.
+ */
+static void base_header(tar_header *header, long mtime)
+{
+    memset(header, 0, sizeof(tar_header));
+    snprintf(header->name, sizeof(header->name), "testfile");
+    snprintf(header->mode, sizeof(header->mode), "0644");
+    snprintf(header->uid, sizeof(header->uid), "01000");
+    snprintf(header->gid, sizeof(header->gid), "01000");
+    snprintf(header->size, sizeof(header->size), "%011o", 0);
+    snprintf(header->mtime, sizeof(header->mtime), "%011lo", mtime);
+    header->typeflag = REGTYPE;
+    snprintf(header->magic, sizeof(header->magic), TMAGIC);
+    memcpy(header->version, TVERSION, TVERSLEN);
+    snprintf(header->uname, sizeof(header->uname), "user");
+    snprintf(header->gname, sizeof(header->gname), "group");
+}
+
+static void build_templates(void)
+{
+    long now = (long)time(NULL);
+
+    tar_header *h = &templates[TEMPLATE_REGULAR].header;
+    base_header(h, now);
+
+    h = &templates[TEMPLATE_SYMLINK].header;
+    base_header(h, now);
+    snprintf(h->name, sizeof(h->name), "testlink");
+    snprintf(h->mode, sizeof(h->mode), "0777");
+    snprintf(h->linkname, sizeof(h->linkname), "testfile");
+    h->typeflag = SYMTYPE;
+
+    h = &templates[TEMPLATE_DIR].header;
+    base_header(h, now);
+    snprintf(h->name, sizeof(h->name), "testdir/");
+    snprintf(h->mode, sizeof(h->mode), "0755");
+    h->typeflag = DIRTYPE;
+
+    // A PAX extended header carrying one "<length> path=testfile\n" record
+    const char *record = " path=testfile\n";
+    size_t length = strlen(record) + 2;
+    pax_payload_size = snprintf(pax_payload, sizeof(pax_payload), "%zu%s", length, record);
+    h = &templates[TEMPLATE_PAX].header;
+    base_header(h, now);
+    snprintf(h->name, sizeof(h->name), "PaxHeaders/testfile");
+    snprintf(h->size, sizeof(h->size), "%011zo", pax_payload_size);
+    h->typeflag = XHDTYPE;
+
+    for (int i = 0; i < TEMPLATE_COUNT; i++)
+    {
+        templates[i].sum = tar_header_sum(&templates[i].header);
+        tar_case_finalize(&templates[i]);
+    }
+}
+
+/**
+ * @brief Build every template once. Later calls are no-ops, and concurrent
+ * first calls wait for the one that builds them.
+ */
+void tar_templates_init(void)
+{
+    pthread_once(&templates_once, build_templates);
+}
+
+/**
+ * @brief Map a template name ("regular", "symlink", "dir", "pax") to its kind.
+ * @return The kind, or -1 if the name is unknown.
+ */
+int tar_template_parse(const char *name)
+{
+    for (int i = 0; i < TEMPLATE_COUNT; i++)
+    {
+        if (strcmp(name, template_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+const char *tar_template_name(enum tar_template_kind kind)
+{
+    return template_names[kind];
+}
+
+const struct tar_case *tar_template(enum tar_template_kind kind)
+{
+    tar_templates_init();
+    return &templates[kind];
+}
+
+/**
+ * @brief Content that must follow the header for it to be well formed
+ * (only the PAX template has any).
+ */
+const char *tar_template_payload(enum tar_template_kind kind, size_t *size)
+{
+    tar_templates_init();
+    *size = kind == TEMPLATE_PAX ? pax_payload_size : 0;
+    return kind == TEMPLATE_PAX ? pax_payload : NULL;
+}
+
+/**
+ * @brief Recompute and store the checksum of a header from scratch.
+ */
+unsigned int tar_compute_checksum(tar_header *entry)
+{
+    memset(entry->chksum, ' ', sizeof(entry->chksum));
+    unsigned int check = 0;
+    unsigned char *raw = (unsigned char *)entry;
+    for (int i = 0; i < HEADER_LENGTH; i++)
+    {
+        check += raw[i];
+    }
+    snprintf(entry->chksum, sizeof(entry->chksum), "%06o0", check);
+    entry->chksum[6] = '\0';
+    entry->chksum[7] = ' ';
+    return check;
+}
+
+/**
+ * @brief Start a new case as a copy of a template, checksum included.
+ */
+void tar_case_init(struct tar_case *c, enum tar_template_kind kind)
+{
+    tar_templates_init();
+    *c = templates[kind];
+}
+
+/**
+ * @brief Overwrite header bytes and update the running sum.
+ *
+ * Bytes written into chksum are stored but do not count, since tar sums that
+ * field as spaces; call this after tar_case_finalize() to corrupt the checksum.
+ */
+void tar_case_patch(struct tar_case *c, size_t offset, const void *data, size_t len)
+{
+    unsigned char *raw = (unsigned char *)&c->header + offset;
+    const unsigned char *src = data;
+    int delta = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t pos = offset + i;
+        int counted = pos - CHKSUM_OFFSET >= CHKSUM_LENGTH; // unsigned wrap covers pos < CHKSUM_OFFSET
+        delta += counted * ((int)src[i] - (int)raw[i]);
+        raw[i] = src[i];
+    }
+    c->sum += delta;
+}
+
+/**
+ * @brief Like tar_case_patch() with @p len copies of @p value.
+ */
+void tar_case_fill(struct tar_case *c, size_t offset, char value, size_t len)
+{
+    unsigned char *raw = (unsigned char *)&c->header + offset;
+    int delta = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        size_t pos = offset + i;
+        int counted = pos - CHKSUM_OFFSET >= CHKSUM_LENGTH;
+        delta += counted * ((int)(unsigned char)value - (int)raw[i]);
+        raw[i] = value;
+    }
+    c->sum += delta;
+}
+
+/**
+ * @brief Start a new case from an existing header, e.g. one read from an archive.
+ * Its checksum field is left untouched until tar_case_finalize().
+ */
+void tar_case_load(struct tar_case *c, const tar_header *header)
+{
+    c->header = *header;
+    c->sum = tar_header_sum(header);
+}
+
+void tar_case_set_byte(struct tar_case *c, size_t offset, char value)
+{
+    tar_case_patch(c, offset, &value, 1);
+}
+
+/**
+ * @brief Write the running sum into chksum in the "%06o\0 " form used by
+ * tar_compute_checksum().
+ */
+void tar_case_finalize(struct tar_case *c)
+{
+    unsigned int sum = c->sum;
+    char *chksum = c->header.chksum;
+    for (int i = 5; i >= 0; i--)
+    {
+        chksum[i] = '0' + (sum & 7);
+        sum >>= 3;
+    }
+    chksum[6] = '\0';
+    chksum[7] = ' ';
+}
@@ -0,0 +1,45 @@
+#ifndef TEMPLATE_H
+#define TEMPLATE_H
+#include <stddef.h>
+#include "constants.h"
+
+enum tar_template_kind
+{
+    TEMPLATE_REGULAR,
+    TEMPLATE_SYMLINK,
+    TEMPLATE_DIR,
+    TEMPLATE_PAX,
+    TEMPLATE_COUNT
+};
+
+/* A header being built from a template, with its byte sum kept up to date so
+ * the checksum never has to be recomputed from scratch. */
+struct tar_case
+{
+    tar_header header;
+    unsigned int sum; /* sum of all header bytes, chksum counted as spaces */
+} __attribute__((aligned(HEADER_LENGTH)));
+
+#define CHKSUM_OFFSET 148 /* offsetof(tar_header, chksum) */
+#define CHKSUM_LENGTH 8
+
+/* Patch a whole header field, e.g. TAR_CASE_PATCH(&c, size, "00000001000", 11) */
+#define TAR_CASE_PATCH(c, field, data, len) \
+    tar_case_patch((c), offsetof(tar_header, field), (data), (len))
+
+void tar_templates_init(void);
+int tar_template_parse(const char *name);
+const char *tar_template_name(enum tar_template_kind kind);
+const struct tar_case *tar_template(enum tar_template_kind kind);
+const char *tar_template_payload(enum tar_template_kind kind, size_t *size);
+
+unsigned int tar_compute_checksum(tar_header *entry);
+unsigned int tar_header_sum(const tar_header *header);
+void tar_case_init(struct tar_case *c, enum tar_template_kind kind);
+void tar_case_load(struct tar_case *c, const tar_header *header);
+void tar_case_patch(struct tar_case *c, size_t offset, const void *data, size_t len);
+void tar_case_fill(struct tar_case *c, size_t offset, char value, size_t len);
+void tar_case_set_byte(struct tar_case *c, size_t offset, char value);
+void tar_case_finalize(struct tar_case *c);
+
+#endif
@@ -1,12 +1,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
-#include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <limits.h>
 #include "utils.h"
+#include "differential.h"
+#include "snapshot.h"
 
 int update_checksum = 1;
+int archive_fd = -1;
+enum tar_template_kind header_template = TEMPLATE_REGULAR;
 struct test_status_t test_status;
 
 void init_test_status(struct test_status_t *ts)
@@ -35,6 +39,14 @@ void print_test_status(struct test_status_t *ts)
     printf("\t   version field    : %d\n", ts->version_fuzzing_success);
     printf("\t   uname field      : %d\n", ts->uname_fuzzing_success);
     printf("\t   gname field      : %d\n", ts->gname_fuzzing_success);
+    printf("\t   numeric fields   : %d\n", ts->numeric_fuzzing_success);
+    printf("\t   seeds            : %d\n", ts->seed_fuzzing_success);
+    printf("\t   crossover        : %d\n", ts->crossover_fuzzing_success);
+    printf("\t   covering array   : %d\n", ts->covering_fuzzing_success);
+    printf("\t   dictionary       : %d\n", ts->dictionary_fuzzing_success);
+    printf("\t   size sweep       : %d\n", ts->sweep_fuzzing_success);
+    printf("\t   stream field     : %d\n", ts->stream_fuzzing_success);
+    printf("\t   pipeline         : %d\n", ts->pipeline_fuzzing_success);
     printf("\t   known crash field: %d\n", ts->known_crash_fuzzing_success);
     printf("\t   multi file field : %d\n", ts->multi_file_fuzzing_success);
     printf("\t   huge content field: %d\n", ts->huge_content_fuzzing_success);
@@ -42,28 +54,66 @@ void print_test_status(struct test_status_t *ts)
     printf("\t   padding field    : %d\n", ts->padding_footer_fuzzing_success);
     printf("\t   end of file field: %d\n\n", ts->end_of_file_fuzzing_success);
     printf("\t   overflow all field:%d\n\n", ts->overflow_all_fuzzing_success);
+    if (differential_enabled())
+        printf("Differential divergences: %d\n\n", ts->differential_divergences);
 }
 
-unsigned int tar_compute_checksum(tar_header *entry)
+/**
+ * @brief Copy the in-memory archive (archive_fd) out to a regular file.
+ */
+void tar_archive_save(const char *name)
 {
-    memset(entry->chksum, ' ', sizeof(entry->chksum));
-    unsigned int check = 0;
-    unsigned char *raw = (unsigned char *)entry;
-    for (int i = 0; i < HEADER_LENGTH; i++)
+    FILE *out = fopen(name, "wb");
+    if (!out)
     {
-        check += raw[i];
+        perror("Failed to save archive");
+        return;
+    }
+    char buf[65536];
+    off_t offset = 0;
+    ssize_t n;
+    while ((n = pread(archive_fd, buf, sizeof(buf), offset)) > 0)
+    {
+        fwrite(buf, n, 1, out);
+        offset += n;
     }
-    snprintf(entry->chksum, sizeof(entry->chksum), "%06o0", check);
-    entry->chksum[6] = '\0';
-    entry->chksum[7] = ' ';
-    return check;
+    fclose(out);
+}
+
+/**
+ * @brief Open the archive for writing, truncating any previous test case.
+ *
+ * In differential mode the archive lives in a memfd shared by all targets,
+ * otherwise it is the regular archive.tar file.
+ */
+FILE *tar_archive_open(void)
+{
+    if (archive_fd == -1)
+        return fopen("archive.tar", "wb");
+    if (ftruncate(archive_fd, 0) == -1 || lseek(archive_fd, 0, SEEK_SET) == -1)
+        return NULL;
+    int fd = dup(archive_fd);
+    if (fd == -1)
+        return NULL;
+    FILE *fp = fdopen(fd, "wb");
+    if (!fp)
+        close(fd);
+    return fp;
 }
 
 int run_extractor(char *path)
 {
+    if (differential_enabled())
+        return differential_run();
+    if (snapshot_enabled())
+        return snapshot_run();
     test_status.number_of_tries++;
-    char cmd[51];
-    snprintf(cmd, sizeof(cmd), "%s archive.tar", path);
+    char cmd[PATH_MAX + sizeof(" archive.tar")];
+    if (snprintf(cmd, sizeof(cmd), "%s archive.tar", path) >= (int)sizeof(cmd))
+    {
+        fprintf(stderr, "Extractor path too long: %s\n", path);
+        return -1;
+    }
     char buf[128];
     FILE *fp = popen(cmd, "r");
     if (!fp)
@@ -97,31 +147,22 @@ int run_extractor(char *path)
     return rv;
 }
 
+/**
+ * @brief Reset a header to the selected template.
+ *
+ * The template is built once at startup, so this is a 512-byte copy rather
+ * than a round of snprintf() calls and a checksum.
+ */
 void tar_init_header(tar_header *header)
 {
-    memset(header, 0, sizeof(tar_header));
-    snprintf(header->name, sizeof(header->name), "testfile");
-    snprintf(header->mode, sizeof(header->mode), "0644");
-    snprintf(header->uid, sizeof(header->uid), "01000");
-    snprintf(header->gid, sizeof(header->gid), "01000");
-    snprintf(header->size, sizeof(header->size), "%011o", 0);
-    snprintf(header->mtime, sizeof(header->mtime), "%011lo", (long)time(NULL));
-    header->typeflag = REGTYPE;
-    snprintf(header->magic, sizeof(header->magic), TMAGIC);
-    memcpy(header->version, TVERSION, TVERSLEN);
-    snprintf(header->uname, sizeof(header->uname), "user");
-    snprintf(header->gname, sizeof(header->gname), "group");
-    if (update_checksum)
-    {
-        tar_compute_checksum(header);
-    }
+    *header = tar_template(header_template)->header;
+    if (!update_checksum)
+        memset(header->chksum, 0, sizeof(header->chksum));
 }
 
-void tar_generate(tar_header *header, char *content, size_t content_size, char *end_data, size_t end_size)
+static void write_archive(tar_header *header, char *content, size_t content_size, char *end_data, size_t end_size)
 {
-    if (update_checksum)
-        tar_compute_checksum(header);
-    FILE *fp = fopen("archive.tar", "wb");
+    FILE *fp = tar_archive_open();
     if (!fp)
     {
         perror("Failed to open archive.tar");
@@ -136,12 +177,101 @@ void tar_generate(tar_header *header, char *content, size_t content_size, char *
     test_status.number_of_tar_created++;
 }
 
+void tar_generate(tar_header *header, char *content, size_t content_size, char *end_data, size_t end_size)
+{
+    if (update_checksum)
+        tar_compute_checksum(header);
+    write_archive(header, content, content_size, end_data, end_size);
+}
+
+/**
+ * @brief Like tar_generate() for a template-built case, whose checksum is
+ * kept incrementally instead of recomputed.
+ */
+void tar_generate_case(struct tar_case *c, char *content, size_t content_size, char *end_data, size_t end_size)
+{
+    if (update_checksum)
+        tar_case_finalize(c);
+    write_archive(&c->header, content, content_size, end_data, end_size);
+}
+
 void tar_generate_empty(tar_header *header)
 {
     char end_data[END_BYTES] = {0};
     tar_generate(header, NULL, 0, end_data, END_BYTES);
 }
 
+void tar_generate_case_empty(struct tar_case *c)
+{
+    char end_data[END_BYTES] = {0};
+    tar_generate_case(c, NULL, 0, end_data, END_BYTES);
+}
+
+/**
+ * @brief Write an archive already assembled in memory, byte for byte.
+ */
+void tar_generate_raw(const char *data, size_t length)
+{
+    FILE *fp = tar_archive_open();
+    if (!fp)
+    {
+        perror("Failed to open archive.tar");
+        return;
+    }
+    if (length > 0)
+        fwrite(data, length, 1, fp);
+    fclose(fp);
+    test_status.number_of_tar_created++;
+}
+
+static void write_segments(const tar_header *header, const char *segment, size_t segment_size,
+                           unsigned long long content_size, unsigned long long zero_size)
+{
+    FILE *fp = tar_archive_open();
+    if (!fp)
+    {
+        perror("Failed to open archive.tar");
+        return;
+    }
+    fwrite(header, sizeof(tar_header), 1, fp);
+    for (unsigned long long left = content_size; left > 0;)
+    {
+        size_t n = left < segment_size ? left : segment_size;
+        fwrite(segment, n, 1, fp);
+        left -= n;
+    }
+    if (fflush(fp) == 0 && ftruncate(fileno(fp), sizeof(tar_header) + content_size + zero_size) == -1)
+        perror("Failed to extend archive.tar");
+    fclose(fp);
+    test_status.number_of_tar_created++;
+}
+
+/**
+ * @brief Write a header, then @p content_size bytes cycling through
+ * @p segment, then @p zero_size zero bytes.
+ *
+ * The payload is never held in memory, and the zeros (sparse payload tail,
+ * padding, end marker) are left as a hole by extending the file, so they
+ * take no space in archive.tar or the memfd whatever their size.
+ */
+void tar_generate_segments(struct tar_case *c, const char *segment, size_t segment_size,
+                           unsigned long long content_size, unsigned long long zero_size)
+{
+    if (update_checksum)
+        tar_case_finalize(c);
+    write_segments(&c->header, segment, segment_size, content_size, zero_size);
+}
+
+/**
+ * @brief Write @p header byte for byte, checksum included, then
+ * @p content_size bytes of @p content and @p zero_size zeros as a hole.
+ */
+void tar_generate_verbatim(const tar_header *header, const char *content, unsigned long long content_size,
+                           unsigned long long zero_size)
+{
+    write_segments(header, content, content_size, content_size, zero_size);
+}
+
 void tar_print_header(tar_header *header)
 {
     printf("-----Header-----\n");
@@ -1,6 +1,8 @@
 #ifndef UTILS_H
 #define UTILS_H
+#include <stdio.h>
 #include "constants.h"
+#include "template.h"
 
 struct test_status_t
 {
@@ -30,6 +32,16 @@ struct test_status_t
     int prefix_fuzzing_success;
     int padding_footer_fuzzing_success;
     int overflow_all_fuzzing_success;
+    int stream_fuzzing_success;
+    int numeric_fuzzing_success;
+    int seed_fuzzing_success;
+    int crossover_fuzzing_success;
+    int covering_fuzzing_success;
+    int dictionary_fuzzing_success;
+    int sweep_fuzzing_success;
+    int pipeline_fuzzing_success;
+
+    int differential_divergences;
 };
 
 void init_test_status(struct test_status_t *ts);
@@ -37,12 +49,22 @@ void print_test_status(struct test_status_t *ts);
 
 void tar_init_header(tar_header *header);
 void tar_print_header(tar_header *header);
-unsigned int tar_compute_checksum(tar_header *entry);
 void tar_generate(tar_header *header, char *content, size_t content_size, char *end_data, size_t end_size);
+void tar_generate_case(struct tar_case *c, char *content, size_t content_size, char *end_data, size_t end_size);
 void tar_generate_empty(tar_header *header);
+void tar_generate_case_empty(struct tar_case *c);
+void tar_generate_raw(const char *data, size_t length);
+void tar_generate_segments(struct tar_case *c, const char *segment, size_t segment_size,
+                           unsigned long long content_size, unsigned long long zero_size);
+void tar_generate_verbatim(const tar_header *header, const char *content, unsigned long long content_size,
+                           unsigned long long zero_size);
+FILE *tar_archive_open(void);
+void tar_archive_save(const char *name);
 int run_extractor(char *path);
 
 extern struct test_status_t test_status;
 extern int update_checksum;
+extern int archive_fd;
+extern enum tar_template_kind header_template;
 
 #endif